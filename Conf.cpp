@@ -27,6 +27,25 @@
 
 const int BUFFER_SIZE = 500;
 
+// A comma separated list of talkgroups or first-last talkgroup ranges
+static void readTGRanges(char* value, std::vector<std::pair<unsigned int, unsigned int>>& ranges)
+{
+	char* p = ::strtok(value, ",\r\n");
+	while (p != NULL) {
+		unsigned int first = (unsigned int)::atoi(p);
+
+		unsigned int last = first;
+		char* dash = ::strchr(p, '-');
+		if (dash != NULL)
+			last = (unsigned int)::atoi(dash + 1);
+
+		if (first > 0U && last >= first)
+			ranges.push_back(std::make_pair(first, last));
+
+		p = ::strtok(NULL, ",\r\n");
+	}
+}
+
 enum SECTION {
   SECTION_NONE,
   SECTION_GENERAL,
@@ -38,6 +57,7 @@ enum SECTION {
   SECTION_DMR,
   SECTION_POCSAG,
   SECTION_DMR_NETWORK,
+  SECTION_DMR_NETWORK2,
   SECTION_POCSAG_NETWORK,
   SECTION_DISPLAY
 };
@@ -86,6 +106,8 @@ m_modemPOCSAGTXLevel(50.0F),
 m_modemRSSIMappingFile(),
 m_modemTrace(false),
 m_modemDebug(false),
+m_modemIOThread(false),
+m_modemFrameBudget(0U),
 m_transparentEnabled(false),
 m_transparentRemoteAddress("127.0.0.1"),
 m_transparentRemotePort(40094U),
@@ -115,11 +137,31 @@ m_dmrNetworkEnabled(false),
 m_dmrNetworkAddress(),
 m_dmrNetworkPort(0U),
 m_dmrNetworkPassword(),
+m_dmrNetworkSecondaryAddress(),
+m_dmrNetworkSecondaryPort(0U),
+m_dmrNetworkSecondaryPassword(),
 m_dmrNetworkOptions(),
 m_dmrNetworkDebug(false),
 m_dmrNetworkSlot1(true),
 m_dmrNetworkSlot2(true),
 m_dmrNetworkModeHang(3U),
+m_dmrNetworkJitter(360U),
+m_dmrNetworkSlotBudget(0U),
+m_dmrNetworkTGRanges(),
+m_dmrNetworkRecvBuffer(0U),
+m_dmrNetworkSendBuffer(0U),
+m_dmrNetworkDSCP(0U),
+m_dmrNetworkPriority(0U),
+m_dmrNetworkBusyPoll(0U),
+m_dmrNetwork2Enabled(false),
+m_dmrNetwork2Address(),
+m_dmrNetwork2Port(0U),
+m_dmrNetwork2Password(),
+m_dmrNetwork2Options(),
+m_dmrNetwork2Debug(false),
+m_dmrNetwork2Slot1(true),
+m_dmrNetwork2Slot2(true),
+m_dmrNetwork2TGRanges(),
 m_pocsagNetworkEnabled(false),
 m_pocsagGatewayAddress(),
 m_pocsagGatewayPort(0U),
@@ -171,6 +213,8 @@ bool CConf::read()
 		  section = SECTION_POCSAG;
 	  else if (::strncmp(buffer, "[DMR Network]", 13U) == 0)
 		  section = SECTION_DMR_NETWORK;
+	  else if (::strncmp(buffer, "[DMR Network 2]", 15U) == 0)
+		  section = SECTION_DMR_NETWORK2;
 	  else if (::strncmp(buffer, "[POCSAG Network]", 16U) == 0)
 		  section = SECTION_POCSAG_NETWORK;
 	  else if (::strncmp(buffer, "[Display]", 9U) == 0)
@@ -311,6 +355,10 @@ bool CConf::read()
 			m_modemTrace = ::atoi(value) == 1;
 		else if (::strcmp(key, "Debug") == 0)
 			m_modemDebug = ::atoi(value) == 1;
+		else if (::strcmp(key, "IOThread") == 0)
+			m_modemIOThread = ::atoi(value) == 1;
+		else if (::strcmp(key, "FrameBudget") == 0)
+			m_modemFrameBudget = (unsigned int)::atoi(value);
 	} else if (section == SECTION_TRANSPARENT) {
 		if (::strcmp(key, "Enable") == 0)
 			m_transparentEnabled = ::atoi(value) == 1;
@@ -419,6 +467,12 @@ bool CConf::read()
 			m_dmrNetworkPort = (unsigned short)::atoi(value);
 		else if (::strcmp(key, "Password") == 0)
 			m_dmrNetworkPassword = value;
+		else if (::strcmp(key, "SecondaryAddress") == 0)
+			m_dmrNetworkSecondaryAddress = value;
+		else if (::strcmp(key, "SecondaryPort") == 0)
+			m_dmrNetworkSecondaryPort = (unsigned short)::atoi(value);
+		else if (::strcmp(key, "SecondaryPassword") == 0)
+			m_dmrNetworkSecondaryPassword = value;
 		else if (::strcmp(key, "Options") == 0)
 			m_dmrNetworkOptions = value;
 		else if (::strcmp(key, "Debug") == 0)
@@ -429,6 +483,41 @@ bool CConf::read()
 			m_dmrNetworkSlot2 = ::atoi(value) == 1;
 		else if (::strcmp(key, "ModeHang") == 0)
 			m_dmrNetworkModeHang = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "Jitter") == 0)
+			m_dmrNetworkJitter = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "SlotBudget") == 0)
+			m_dmrNetworkSlotBudget = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "TGRanges") == 0)
+			readTGRanges(value, m_dmrNetworkTGRanges);
+		else if (::strcmp(key, "RecvBuffer") == 0)
+			m_dmrNetworkRecvBuffer = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "SendBuffer") == 0)
+			m_dmrNetworkSendBuffer = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "DSCP") == 0)
+			m_dmrNetworkDSCP = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "Priority") == 0)
+			m_dmrNetworkPriority = (unsigned int)::atoi(value);
+		else if (::strcmp(key, "BusyPoll") == 0)
+			m_dmrNetworkBusyPoll = (unsigned int)::atoi(value);
+	} else if (section == SECTION_DMR_NETWORK2) {
+		if (::strcmp(key, "Enable") == 0)
+			m_dmrNetwork2Enabled = ::atoi(value) == 1;
+		else if (::strcmp(key, "Address") == 0)
+			m_dmrNetwork2Address = value;
+		else if (::strcmp(key, "Port") == 0)
+			m_dmrNetwork2Port = (unsigned short)::atoi(value);
+		else if (::strcmp(key, "Password") == 0)
+			m_dmrNetwork2Password = value;
+		else if (::strcmp(key, "Options") == 0)
+			m_dmrNetwork2Options = value;
+		else if (::strcmp(key, "Debug") == 0)
+			m_dmrNetwork2Debug = ::atoi(value) == 1;
+		else if (::strcmp(key, "Slot1") == 0)
+			m_dmrNetwork2Slot1 = ::atoi(value) == 1;
+		else if (::strcmp(key, "Slot2") == 0)
+			m_dmrNetwork2Slot2 = ::atoi(value) == 1;
+		else if (::strcmp(key, "TGRanges") == 0)
+			readTGRanges(value, m_dmrNetwork2TGRanges);
 	} else if (section == SECTION_POCSAG_NETWORK) {
 		if (::strcmp(key, "Enable") == 0)
 			m_pocsagNetworkEnabled = ::atoi(value) == 1;
@@ -669,6 +758,16 @@ bool CConf::getModemDebug() const
 	return m_modemDebug;
 }
 
+bool CConf::getModemIOThread() const
+{
+	return m_modemIOThread;
+}
+
+unsigned int CConf::getModemFrameBudget() const
+{
+	return m_modemFrameBudget;
+}
+
 bool CConf::getTransparentEnabled() const
 {
 	return m_transparentEnabled;
@@ -814,6 +913,21 @@ std::string CConf::getDMRNetworkPassword() const
 	return m_dmrNetworkPassword;
 }
 
+std::string CConf::getDMRNetworkSecondaryAddress() const
+{
+	return m_dmrNetworkSecondaryAddress;
+}
+
+unsigned short CConf::getDMRNetworkSecondaryPort() const
+{
+	return m_dmrNetworkSecondaryPort;
+}
+
+std::string CConf::getDMRNetworkSecondaryPassword() const
+{
+	return m_dmrNetworkSecondaryPassword;
+}
+
 std::string CConf::getDMRNetworkOptions() const
 {
 	return m_dmrNetworkOptions;
@@ -824,6 +938,46 @@ unsigned int CConf::getDMRNetworkModeHang() const
 	return m_dmrNetworkModeHang;
 }
 
+unsigned int CConf::getDMRNetworkJitter() const
+{
+	return m_dmrNetworkJitter;
+}
+
+unsigned int CConf::getDMRNetworkSlotBudget() const
+{
+	return m_dmrNetworkSlotBudget;
+}
+
+unsigned int CConf::getDMRNetworkRecvBuffer() const
+{
+	return m_dmrNetworkRecvBuffer;
+}
+
+unsigned int CConf::getDMRNetworkSendBuffer() const
+{
+	return m_dmrNetworkSendBuffer;
+}
+
+unsigned int CConf::getDMRNetworkDSCP() const
+{
+	return m_dmrNetworkDSCP;
+}
+
+unsigned int CConf::getDMRNetworkPriority() const
+{
+	return m_dmrNetworkPriority;
+}
+
+unsigned int CConf::getDMRNetworkBusyPoll() const
+{
+	return m_dmrNetworkBusyPoll;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> CConf::getDMRNetworkTGRanges() const
+{
+	return m_dmrNetworkTGRanges;
+}
+
 bool CConf::getDMRNetworkDebug() const
 {
 	return m_dmrNetworkDebug;
@@ -839,6 +993,51 @@ bool CConf::getDMRNetworkSlot2() const
 	return m_dmrNetworkSlot2;
 }
 
+bool CConf::getDMRNetwork2Enabled() const
+{
+	return m_dmrNetwork2Enabled;
+}
+
+std::string CConf::getDMRNetwork2Address() const
+{
+	return m_dmrNetwork2Address;
+}
+
+unsigned short CConf::getDMRNetwork2Port() const
+{
+	return m_dmrNetwork2Port;
+}
+
+std::string CConf::getDMRNetwork2Password() const
+{
+	return m_dmrNetwork2Password;
+}
+
+std::string CConf::getDMRNetwork2Options() const
+{
+	return m_dmrNetwork2Options;
+}
+
+bool CConf::getDMRNetwork2Debug() const
+{
+	return m_dmrNetwork2Debug;
+}
+
+bool CConf::getDMRNetwork2Slot1() const
+{
+	return m_dmrNetwork2Slot1;
+}
+
+bool CConf::getDMRNetwork2Slot2() const
+{
+	return m_dmrNetwork2Slot2;
+}
+
+std::vector<std::pair<unsigned int, unsigned int>> CConf::getDMRNetwork2TGRanges() const
+{
+	return m_dmrNetwork2TGRanges;
+}
+
 bool CConf::getPOCSAGNetworkEnabled() const
 {
 	return m_pocsagNetworkEnabled;
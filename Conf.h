@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <utility>
 
 class CConf
 {
@@ -80,6 +81,8 @@ public:
   std::string  getModemRSSIMappingFile() const;
   bool         getModemTrace() const;
   bool         getModemDebug() const;
+  bool         getModemIOThread() const;
+  unsigned int getModemFrameBudget() const;
 
   // The Transparent Data section
   bool         getTransparentEnabled() const;
@@ -117,11 +120,33 @@ public:
   std::string  getDMRNetworkAddress() const;
   unsigned short getDMRNetworkPort() const;
   std::string  getDMRNetworkPassword() const;
+  std::string  getDMRNetworkSecondaryAddress() const;
+  unsigned short getDMRNetworkSecondaryPort() const;
+  std::string  getDMRNetworkSecondaryPassword() const;
   std::string  getDMRNetworkOptions() const;
   bool         getDMRNetworkDebug() const;
   bool         getDMRNetworkSlot1() const;
   bool         getDMRNetworkSlot2() const;
   unsigned int getDMRNetworkModeHang() const;
+  unsigned int getDMRNetworkJitter() const;
+  unsigned int getDMRNetworkSlotBudget() const;
+  std::vector<std::pair<unsigned int, unsigned int>> getDMRNetworkTGRanges() const;
+  unsigned int getDMRNetworkRecvBuffer() const;
+  unsigned int getDMRNetworkSendBuffer() const;
+  unsigned int getDMRNetworkDSCP() const;
+  unsigned int getDMRNetworkPriority() const;
+  unsigned int getDMRNetworkBusyPoll() const;
+
+  // The DMR Network 2 section
+  bool         getDMRNetwork2Enabled() const;
+  std::string  getDMRNetwork2Address() const;
+  unsigned short getDMRNetwork2Port() const;
+  std::string  getDMRNetwork2Password() const;
+  std::string  getDMRNetwork2Options() const;
+  bool         getDMRNetwork2Debug() const;
+  bool         getDMRNetwork2Slot1() const;
+  bool         getDMRNetwork2Slot2() const;
+  std::vector<std::pair<unsigned int, unsigned int>> getDMRNetwork2TGRanges() const;
 
   // The POCSAG Network section
   bool         getPOCSAGNetworkEnabled() const;
@@ -186,6 +211,8 @@ private:
   std::string  m_modemRSSIMappingFile;
   bool         m_modemTrace;
   bool         m_modemDebug;
+  bool         m_modemIOThread;
+  unsigned int m_modemFrameBudget;
 
   bool         m_transparentEnabled;
   std::string  m_transparentRemoteAddress;
@@ -219,11 +246,32 @@ private:
   std::string  m_dmrNetworkAddress;
   unsigned int m_dmrNetworkPort;
   std::string  m_dmrNetworkPassword;
+  std::string  m_dmrNetworkSecondaryAddress;
+  unsigned int m_dmrNetworkSecondaryPort;
+  std::string  m_dmrNetworkSecondaryPassword;
   std::string  m_dmrNetworkOptions;
   bool         m_dmrNetworkDebug;
   bool         m_dmrNetworkSlot1;
   bool         m_dmrNetworkSlot2;
   unsigned int m_dmrNetworkModeHang;
+  unsigned int m_dmrNetworkJitter;
+  unsigned int m_dmrNetworkSlotBudget;
+  std::vector<std::pair<unsigned int, unsigned int>> m_dmrNetworkTGRanges;
+  unsigned int m_dmrNetworkRecvBuffer;
+  unsigned int m_dmrNetworkSendBuffer;
+  unsigned int m_dmrNetworkDSCP;
+  unsigned int m_dmrNetworkPriority;
+  unsigned int m_dmrNetworkBusyPoll;
+
+  bool         m_dmrNetwork2Enabled;
+  std::string  m_dmrNetwork2Address;
+  unsigned int m_dmrNetwork2Port;
+  std::string  m_dmrNetwork2Password;
+  std::string  m_dmrNetwork2Options;
+  bool         m_dmrNetwork2Debug;
+  bool         m_dmrNetwork2Slot1;
+  bool         m_dmrNetwork2Slot2;
+  std::vector<std::pair<unsigned int, unsigned int>> m_dmrNetwork2TGRanges;
 
   bool         m_pocsagNetworkEnabled;
   std::string  m_pocsagGatewayAddress;
@@ -21,12 +21,13 @@
 #include <cassert>
 #include <algorithm>
 
-CDMRControl::CDMRControl(unsigned int id, unsigned int colorCode, unsigned int callHang, bool selfOnly, bool embeddedLCOnly, bool dumpTAData, const std::vector<unsigned int>& prefixes, const std::vector<unsigned int>& blacklist, const std::vector<unsigned int>& whitelist, const std::vector<unsigned int>& slot1TGWhitelist, const std::vector<unsigned int>& slot2TGWhitelist, unsigned int timeout, CModem* modem, CDMRNetwork* network, CDisplay* display, bool duplex, CRSSIInterpolator* rssi, DMR_OVCM_TYPES ovcm) :
+CDMRControl::CDMRControl(unsigned int id, unsigned int colorCode, unsigned int callHang, bool selfOnly, bool embeddedLCOnly, bool dumpTAData, const std::vector<unsigned int>& prefixes, const std::vector<unsigned int>& blacklist, const std::vector<unsigned int>& whitelist, const std::vector<unsigned int>& slot1TGWhitelist, const std::vector<unsigned int>& slot2TGWhitelist, unsigned int timeout, unsigned int jitter, unsigned int slotBudget, CModem* modem, const std::vector<CDMRNetwork*>& networks, CDisplay* display, bool duplex, CRSSIInterpolator* rssi, DMR_OVCM_TYPES ovcm) :
 m_colorCode(colorCode),
 m_modem(modem),
-m_network(network),
-m_slot1(1U, timeout),
-m_slot2(2U, timeout)
+m_networks(networks),
+m_slotBudget(slotBudget),
+m_slot1(1U, timeout, jitter),
+m_slot2(2U, timeout, jitter)
 {
 	assert(id != 0U);
 	assert(modem != NULL);
@@ -36,7 +37,7 @@ m_slot2(2U, timeout)
 	// Load black and white lists to DMRAccessControl
 	CDMRAccessControl::init(blacklist, whitelist, slot1TGWhitelist, slot2TGWhitelist, selfOnly, prefixes, id);
 
-	CDMRSlot::init(colorCode, embeddedLCOnly, dumpTAData, callHang, modem, network, display, duplex, rssi, ovcm);
+	CDMRSlot::init(colorCode, embeddedLCOnly, dumpTAData, callHang, modem, networks, display, duplex, rssi, ovcm);
 }
 
 CDMRControl::~CDMRControl()
@@ -74,45 +75,57 @@ bool CDMRControl::processWakeup(const unsigned char* data)
 	return true;
 }
 
-bool CDMRControl::writeModemSlot1(unsigned char *data, unsigned int len)
+bool CDMRControl::writeModemSlot1(unsigned char *data, unsigned int len, unsigned long long timestamp)
 {
 	assert(data != NULL);
 
-	return m_slot1.writeModem(data, len);
+	return m_slot1.writeModem(data, len, timestamp);
 }
 
-bool CDMRControl::writeModemSlot2(unsigned char *data, unsigned int len)
+bool CDMRControl::writeModemSlot2(unsigned char *data, unsigned int len, unsigned long long timestamp)
 {
 	assert(data != NULL);
 
-	return m_slot2.writeModem(data, len);
+	return m_slot2.writeModem(data, len, timestamp);
 }
 
-unsigned int CDMRControl::readModemSlot1(unsigned char *data)
+unsigned int CDMRControl::readModemSlot1(unsigned char *data, unsigned long long& timestamp)
 {
 	assert(data != NULL);
 
-	return m_slot1.readModem(data);
+	return m_slot1.readModem(data, timestamp);
 }
 
-unsigned int CDMRControl::readModemSlot2(unsigned char *data)
+unsigned int CDMRControl::readModemSlot2(unsigned char *data, unsigned long long& timestamp)
 {
 	assert(data != NULL);
 
-	return m_slot2.readModem(data);
+	return m_slot2.readModem(data, timestamp);
 }
 
 void CDMRControl::clock()
 {
-	if (m_network != NULL) {
-		CDMRData data;
-		bool ret = m_network->read(data);
-		if (ret) {
-			unsigned int slotNo = data.getSlotNo();
-			switch (slotNo) {
-				case 1U: m_slot1.writeNetwork(data); break;
-				case 2U: m_slot2.writeNetwork(data); break;
-				default: LogError("Invalid slot no %u", slotNo); break;
+	// Each session only hands over the slots and talkgroups routed to it. Everything waiting is taken,
+	// a frame from each slot in turn so that a burst on one doesn't hold up the other, up to the budget
+	CDMRData data;
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_networks.begin(); it != m_networks.end(); ++it) {
+		unsigned int count1 = 0U;
+		unsigned int count2 = 0U;
+
+		bool more = true;
+		while (more) {
+			more = false;
+
+			if ((m_slotBudget == 0U || count1 < m_slotBudget) && (*it)->read(1U, data)) {
+				m_slot1.writeNetwork(data);
+				count1++;
+				more = true;
+			}
+
+			if ((m_slotBudget == 0U || count2 < m_slotBudget) && (*it)->read(2U, data)) {
+				m_slot2.writeNetwork(data);
+				count2++;
+				more = true;
 			}
 		}
 	}
@@ -121,6 +134,20 @@ void CDMRControl::clock()
 	m_slot2.clock();
 }
 
+unsigned int CDMRControl::getTimeout()
+{
+	// Network frames are waiting to be read
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_networks.begin(); it != m_networks.end(); ++it) {
+		if ((*it)->hasData())
+			return 0U;
+	}
+
+	unsigned int timeout1 = m_slot1.getTimeout();
+	unsigned int timeout2 = m_slot2.getTimeout();
+
+	return timeout1 < timeout2 ? timeout1 : timeout2;
+}
+
 bool CDMRControl::isBusy() const
 {
 	if (m_slot1.isBusy())
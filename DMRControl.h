@@ -29,19 +29,21 @@
 
 class CDMRControl {
 public:
-	CDMRControl(unsigned int id, unsigned int colorCode, unsigned int callHang, bool selfOnly, bool embeddedLCOnly, bool dumpTAData, const std::vector<unsigned int>& prefixes, const std::vector<unsigned int>& blacklist, const std::vector<unsigned int>& whitelist, const std::vector<unsigned int>& slot1TGWhitelist, const std::vector<unsigned int>& slot2TGWhitelist, unsigned int timeout, CModem* modem, CDMRNetwork* network, CDisplay* display, bool duplex, CRSSIInterpolator* rssi, DMR_OVCM_TYPES ovcm);
+	CDMRControl(unsigned int id, unsigned int colorCode, unsigned int callHang, bool selfOnly, bool embeddedLCOnly, bool dumpTAData, const std::vector<unsigned int>& prefixes, const std::vector<unsigned int>& blacklist, const std::vector<unsigned int>& whitelist, const std::vector<unsigned int>& slot1TGWhitelist, const std::vector<unsigned int>& slot2TGWhitelist, unsigned int timeout, unsigned int jitter, unsigned int slotBudget, CModem* modem, const std::vector<CDMRNetwork*>& networks, CDisplay* display, bool duplex, CRSSIInterpolator* rssi, DMR_OVCM_TYPES ovcm);
 	~CDMRControl();
 
 	bool processWakeup(const unsigned char* data);
 
-	bool writeModemSlot1(unsigned char* data, unsigned int len);
-	bool writeModemSlot2(unsigned char* data, unsigned int len);
+	bool writeModemSlot1(unsigned char* data, unsigned int len, unsigned long long timestamp);
+	bool writeModemSlot2(unsigned char* data, unsigned int len, unsigned long long timestamp);
 
-	unsigned int readModemSlot1(unsigned char* data);
-	unsigned int readModemSlot2(unsigned char* data);
+	unsigned int readModemSlot1(unsigned char* data, unsigned long long& timestamp);
+	unsigned int readModemSlot2(unsigned char* data, unsigned long long& timestamp);
 
 	void clock();
 
+	unsigned int getTimeout();
+
 	bool isBusy() const;
 
 	void enable(bool enabled);
@@ -49,7 +51,8 @@ public:
 private:
 	unsigned int m_colorCode;
 	CModem*      m_modem;
-	CDMRNetwork* m_network;
+	std::vector<CDMRNetwork*> m_networks;
+	unsigned int m_slotBudget;
 	CDMRSlot     m_slot1;
 	CDMRSlot     m_slot2;
 };
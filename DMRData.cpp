@@ -23,7 +23,7 @@
 
 CDMRData::CDMRData(const CDMRData& data) :
 m_slotNo(data.m_slotNo),
-m_data(NULL),
+m_data(),
 m_srcId(data.m_srcId),
 m_dstId(data.m_dstId),
 m_flco(data.m_flco),
@@ -31,15 +31,16 @@ m_dataType(data.m_dataType),
 m_seqNo(data.m_seqNo),
 m_n(data.m_n),
 m_ber(data.m_ber),
-m_rssi(data.m_rssi)
+m_rssi(data.m_rssi),
+m_streamId(data.m_streamId),
+m_timestamp(data.m_timestamp)
 {
-	m_data = new unsigned char[2U * DMR_FRAME_LENGTH_BYTES];
-	::memcpy(m_data, data.m_data, 2U * DMR_FRAME_LENGTH_BYTES);
+	::memcpy(m_data, data.m_data, DMR_FRAME_LENGTH_BYTES);
 }
 
 CDMRData::CDMRData() :
 m_slotNo(1U),
-m_data(NULL),
+m_data(),
 m_srcId(0U),
 m_dstId(0U),
 m_flco(FLCO_GROUP),
@@ -47,14 +48,14 @@ m_dataType(0U),
 m_seqNo(0U),
 m_n(0U),
 m_ber(0U),
-m_rssi(0U)
+m_rssi(0U),
+m_streamId(0U),
+m_timestamp(0ULL)
 {
-	m_data = new unsigned char[2U * DMR_FRAME_LENGTH_BYTES];
 }
 
 CDMRData::~CDMRData()
 {
-	delete[] m_data;
 }
 
 CDMRData& CDMRData::operator=(const CDMRData& data)
@@ -71,6 +72,8 @@ CDMRData& CDMRData::operator=(const CDMRData& data)
 		m_n        = data.m_n;
 		m_ber      = data.m_ber;
 		m_rssi     = data.m_rssi;
+		m_streamId = data.m_streamId;
+		m_timestamp = data.m_timestamp;
 	}
 
 	return *this;
@@ -168,6 +171,26 @@ void CDMRData::setRSSI(unsigned char rssi)
 	m_rssi = rssi;
 }
 
+unsigned int CDMRData::getStreamId() const
+{
+	return m_streamId;
+}
+
+void CDMRData::setStreamId(unsigned int streamId)
+{
+	m_streamId = streamId;
+}
+
+unsigned long long CDMRData::getTimestamp() const
+{
+	return m_timestamp;
+}
+
+void CDMRData::setTimestamp(unsigned long long timestamp)
+{
+	m_timestamp = timestamp;
+}
+
 unsigned int CDMRData::getData(unsigned char* buffer) const
 {
 	assert(buffer != NULL);
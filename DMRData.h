@@ -15,6 +15,7 @@
 
 #include "DMRDefines.h"
 
+// Small enough to keep on the stack and copy by value, the payload is held inline
 class CDMRData {
 public:
 	CDMRData(const CDMRData& data);
@@ -50,12 +51,19 @@ public:
 	unsigned char getRSSI() const;
 	void setRSSI(unsigned char rssi);
 
+	unsigned int getStreamId() const;
+	void setStreamId(unsigned int streamId);
+
+	// When the frame reached the host, in ns on the realtime clock, zero if not known
+	unsigned long long getTimestamp() const;
+	void setTimestamp(unsigned long long timestamp);
+
 	void setData(const unsigned char* buffer);
 	unsigned int getData(unsigned char* buffer) const;
 
 private:
 	unsigned int   m_slotNo;
-	unsigned char* m_data;
+	unsigned char  m_data[DMR_FRAME_LENGTH_BYTES];
 	unsigned int   m_srcId;
 	unsigned int   m_dstId;
 	FLCO           m_flco;
@@ -64,4 +72,6 @@ private:
 	unsigned char  m_n;
 	unsigned char  m_ber;
 	unsigned char  m_rssi;
+	unsigned int   m_streamId;
+	unsigned long long m_timestamp;
 };
@@ -274,15 +274,17 @@ void CDMREmbeddedData::decodeEmbeddedData()
 	m_FLCO = FLCO(flco & 0x3FU);
 }
 
-CDMRLC* CDMREmbeddedData::getLC() const
+bool CDMREmbeddedData::getLC(CDMRLC& lc) const
 {
 	if (!m_valid)
-		return NULL;
+		return false;
 
 	if (m_FLCO != FLCO_GROUP && m_FLCO != FLCO_USER_USER)
-		return NULL;
+		return false;
 
-	return new CDMRLC(m_data);
+	lc = CDMRLC(m_data);
+
+	return true;
 }
 
 bool CDMREmbeddedData::isValid() const
@@ -36,7 +36,7 @@ public:
 
 	bool addData(const unsigned char* data, unsigned char lcss);
 
-	CDMRLC* getLC() const;
+	bool getLC(CDMRLC& lc) const;
 	void setLC(const CDMRLC& lc);
 
 	unsigned char getData(unsigned char* data, unsigned char n) const;
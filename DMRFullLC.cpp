@@ -36,7 +36,7 @@ CDMRFullLC::~CDMRFullLC()
 {
 }
 
-CDMRLC* CDMRFullLC::decode(const unsigned char* data, unsigned char type)
+bool CDMRFullLC::decode(const unsigned char* data, unsigned char type, CDMRLC& lc)
 {
 	assert(data != NULL);
 
@@ -58,13 +58,15 @@ CDMRLC* CDMRFullLC::decode(const unsigned char* data, unsigned char type)
 
 		default:
 			::LogError("Unsupported LC type - %d", int(type));
-			return NULL;
+			return false;
 	}
 
 	if (!CRS129::check(lcData))
-		return NULL;
+		return false;
 
-	return new CDMRLC(lcData);
+	lc = CDMRLC(lcData);
+
+	return true;
 }
 
 void CDMRFullLC::encode(const CDMRLC& lc, unsigned char* data, unsigned char type)
@@ -29,7 +29,7 @@ public:
 	CDMRFullLC();
 	~CDMRFullLC();
 
-	CDMRLC* decode(const unsigned char* data, unsigned char type);
+	bool decode(const unsigned char* data, unsigned char type, CDMRLC& lc);
 
 	void encode(const CDMRLC& lc, unsigned char* data, unsigned char type);
 
@@ -0,0 +1,279 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "DMRJitterBuffer.h"
+#include "Log.h"
+
+#include <cassert>
+
+const unsigned int DMR_FRAME_TIME = 60U;
+
+// One entry for every possible sequence number, so the sequence number is the index
+const unsigned int JITTER_BUFFER_SIZE = 256U;
+
+// A jump in arrival time beyond this is an outage rather than jitter
+const unsigned int MAX_JITTER_SAMPLE = 1000U;
+
+// A frame further behind the head than this, or after a longer silence, is the stream jumping ahead
+const unsigned int MAX_LATE_FRAMES = 32U;
+
+// After a silence this long the sequence number says nothing about where the stream has got to
+const unsigned int MAX_GAP_TIME = 128U * DMR_FRAME_TIME;
+
+CDMRJitterBuffer::CDMRJitterBuffer(const char* name, unsigned int maxDepth) :
+m_name(name),
+m_maxDepth(maxDepth),
+m_depth(0U),
+m_frames(NULL),
+m_valid(NULL),
+m_count(0U),
+m_running(false),
+m_playing(false),
+m_streamId(0U),
+m_headSeqNo(0U),
+m_highSeqNo(0U),
+m_lastSeqNo(0U),
+m_lastArrival(0U),
+m_playout(0U),
+m_jitter(0U),
+m_stopWatch(),
+m_received(0U),
+m_late(0U),
+m_reordered(0U),
+m_concealed(0U)
+{
+	assert(name != NULL);
+
+	m_frames = new CDMRData[JITTER_BUFFER_SIZE];
+	m_valid  = new bool[JITTER_BUFFER_SIZE];
+
+	for (unsigned int i = 0U; i < JITTER_BUFFER_SIZE; i++)
+		m_valid[i] = false;
+
+	m_stopWatch.start();
+}
+
+CDMRJitterBuffer::~CDMRJitterBuffer()
+{
+	delete[] m_frames;
+	delete[] m_valid;
+}
+
+void CDMRJitterBuffer::addData(const CDMRData& data)
+{
+	unsigned int now = m_stopWatch.elapsed();
+
+	unsigned int streamId = data.getStreamId();
+	unsigned char seqNo   = data.getSeqNo();
+
+	if (!m_running || streamId != m_streamId)
+		start(streamId, seqNo, now);
+	else if (m_playing && (now - m_lastArrival) > MAX_GAP_TIME)
+		restart(seqNo, now);
+	else
+		updateJitter(seqNo, now);
+
+	m_received++;
+
+	unsigned char offset = seqNo - m_headSeqNo;
+	if (offset >= 128U) {
+		unsigned char behind = m_headSeqNo - seqNo;
+
+		// Before anything has been played an earlier frame can still go first
+		if (!m_playing) {
+			m_headSeqNo = seqNo;
+		} else if (behind > MAX_LATE_FRAMES || (now - m_lastArrival) > MAX_JITTER_SAMPLE) {
+			// Too far behind, or after too long a silence, to be a late frame, so the stream has jumped ahead
+			// and playout starts again from here
+			restart(seqNo, now);
+		} else {
+			m_late++;
+
+			// Too shallow for this stream, hold playout back a frame rather than keep concealing
+			if (m_depth + DMR_FRAME_TIME <= m_maxDepth) {
+				m_depth   += DMR_FRAME_TIME;
+				m_playout += DMR_FRAME_TIME;
+			}
+			return;
+		}
+	}
+
+	// Already waiting to be played
+	if (m_valid[seqNo])
+		return;
+
+	m_frames[seqNo] = data;
+	m_valid[seqNo]  = true;
+	m_count++;
+
+	unsigned char behind = m_highSeqNo - seqNo;
+	if (behind > 0U && behind < 128U)
+		m_reordered++;
+	else
+		m_highSeqNo = seqNo;
+}
+
+JB_STATUS CDMRJitterBuffer::getData(CDMRData& data)
+{
+	if (!m_running || m_count == 0U)
+		return JBS_NO_DATA;
+
+	unsigned int now = m_stopWatch.elapsed();
+	if (int(now - m_playout) < 0)
+		return JBS_NO_DATA;
+
+	// After running dry skip the empty slots whose time has passed rather than conceal them one by one,
+	// then restart the cadence from here
+	if (int(now - m_playout) > int(DMR_FRAME_TIME)) {
+		while (!m_valid[m_headSeqNo] && int(now - m_playout) >= 0) {
+			m_headSeqNo++;
+			m_playout += DMR_FRAME_TIME;
+		}
+
+		if (int(now - m_playout) < 0)
+			return JBS_NO_DATA;
+
+		m_playout = now;
+	}
+
+	// Never hold more than the maximum depth, after a burst the oldest frames are too late to play
+	unsigned char span = m_highSeqNo - m_headSeqNo;
+	while (span < 128U && (span * DMR_FRAME_TIME) > m_maxDepth) {
+		if (m_valid[m_headSeqNo]) {
+			m_valid[m_headSeqNo] = false;
+			m_count--;
+			m_late++;
+		}
+
+		m_headSeqNo++;
+		span--;
+	}
+
+	m_playing = true;
+
+	JB_STATUS status;
+	if (m_valid[m_headSeqNo]) {
+		data = m_frames[m_headSeqNo];
+		m_valid[m_headSeqNo] = false;
+		m_count--;
+		status = JBS_DATA;
+	} else {
+		// A later frame is waiting, so this one is lost or too late to wait for
+		m_concealed++;
+		status = JBS_MISSING;
+	}
+
+	m_headSeqNo++;
+	m_playout += DMR_FRAME_TIME;
+
+	return status;
+}
+
+unsigned int CDMRJitterBuffer::getTimeout()
+{
+	if (!m_running || m_count == 0U)
+		return 0xFFFFFFFFU;
+
+	unsigned int now = m_stopWatch.elapsed();
+	if (int(m_playout - now) <= 0)
+		return 0U;
+
+	return m_playout - now;
+}
+
+void CDMRJitterBuffer::reset()
+{
+	for (unsigned int i = 0U; i < JITTER_BUFFER_SIZE; i++)
+		m_valid[i] = false;
+
+	m_count   = 0U;
+	m_running = false;
+	m_playing = false;
+}
+
+unsigned int CDMRJitterBuffer::getLate() const
+{
+	return m_late;
+}
+
+unsigned int CDMRJitterBuffer::getReordered() const
+{
+	return m_reordered;
+}
+
+unsigned int CDMRJitterBuffer::getConcealed() const
+{
+	return m_concealed;
+}
+
+void CDMRJitterBuffer::logStats() const
+{
+	if (m_received == 0U)
+		return;
+
+	LogMessage("%s, jitter buffer: %ums deep, %ums jitter, %u late, %u reordered, %u concealed", m_name, m_depth, m_jitter >> 4, m_late, m_reordered, m_concealed);
+}
+
+void CDMRJitterBuffer::start(unsigned int streamId, unsigned char seqNo, unsigned int now)
+{
+	m_streamId = streamId;
+
+	m_received  = 0U;
+	m_late      = 0U;
+	m_reordered = 0U;
+	m_concealed = 0U;
+
+	restart(seqNo, now);
+}
+
+void CDMRJitterBuffer::restart(unsigned char seqNo, unsigned int now)
+{
+	reset();
+
+	// Wait long enough for most of the jitter seen so far, the estimate carries over from earlier streams
+	m_depth = 3U * (m_jitter >> 4) + DMR_FRAME_TIME / 2U;
+	if (m_depth > m_maxDepth)
+		m_depth = m_maxDepth;
+
+	m_running     = true;
+	m_headSeqNo   = seqNo;
+	m_highSeqNo   = seqNo;
+	m_lastSeqNo   = seqNo;
+	m_lastArrival = now;
+	m_playout     = now + m_depth;
+}
+
+void CDMRJitterBuffer::updateJitter(unsigned char seqNo, unsigned int now)
+{
+	// Only frames arriving in order say anything about the spacing
+	unsigned char frames = seqNo - m_lastSeqNo;
+	if (frames == 0U || frames >= 128U)
+		return;
+
+	int d = int(now - m_lastArrival) - int(frames * DMR_FRAME_TIME);
+	unsigned int sample = d < 0 ? -d : d;
+	if (sample > MAX_JITTER_SAMPLE)
+		sample = MAX_JITTER_SAMPLE;
+
+	// The RFC 3550 estimator, kept in sixteenths of a ms
+	m_jitter += sample - ((m_jitter + 8U) >> 4);
+
+	m_lastSeqNo   = seqNo;
+	m_lastArrival = now;
+}
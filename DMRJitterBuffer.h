@@ -0,0 +1,78 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#pragma once
+
+#include "StopWatch.h"
+#include "DMRData.h"
+
+enum JB_STATUS {
+	JBS_NO_DATA,
+	JBS_DATA,
+	JBS_MISSING
+};
+
+// Holds network frames for one slot and hands them back in sequence number order, one every
+// 60ms. The delay before a new stream starts playing follows the measured inter-arrival jitter.
+class CDMRJitterBuffer {
+public:
+	CDMRJitterBuffer(const char* name, unsigned int maxDepth);
+	~CDMRJitterBuffer();
+
+	void addData(const CDMRData& data);
+
+	JB_STATUS getData(CDMRData& data);
+
+	// Time in ms until getData() has something to return
+	unsigned int getTimeout();
+
+	void reset();
+
+	unsigned int getLate() const;
+	unsigned int getReordered() const;
+	unsigned int getConcealed() const;
+
+	void logStats() const;
+
+private:
+	const char*    m_name;
+	unsigned int   m_maxDepth;
+	unsigned int   m_depth;
+	CDMRData*      m_frames;
+	bool*          m_valid;
+	unsigned int   m_count;
+	bool           m_running;
+	bool           m_playing;
+	unsigned int   m_streamId;
+	unsigned char  m_headSeqNo;
+	unsigned char  m_highSeqNo;
+	unsigned char  m_lastSeqNo;
+	unsigned int   m_lastArrival;
+	unsigned int   m_playout;
+	unsigned int   m_jitter;
+	CStopWatch     m_stopWatch;
+	unsigned int   m_received;
+	unsigned int   m_late;
+	unsigned int   m_reordered;
+	unsigned int   m_concealed;
+
+	void start(unsigned int streamId, unsigned char seqNo, unsigned int now);
+	void restart(unsigned char seqNo, unsigned int now);
+	void updateJitter(unsigned char seqNo, unsigned int now);
+};
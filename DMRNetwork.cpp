@@ -18,6 +18,7 @@
 
 #include "DMRNetwork.h"
 
+#include "DNSResolver.h"
 #include "SHA256.h"
 #include "Utils.h"
 #include "Log.h"
@@ -26,18 +27,56 @@
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
+#include <utility>
 
 const unsigned int BUFFER_LENGTH = 500U;
 
+const unsigned int NETWORK_BATCH_SIZE = 16U;
+
+// Each slot queues decoded frames of about 70 bytes, this holds over ten seconds of them so that a
+// whole call arriving in one burst fits
+const unsigned int RX_QUEUE_LENGTH = 10000U;
+
 const unsigned int HOMEBREW_DATA_PACKET_LENGTH = 55U;
 
-CDMRNetwork::CDMRNetwork(const std::string& address, unsigned short port, unsigned int id, const std::string& password, bool duplex, const char* version, bool debug, bool slot1, bool slot2, const char* hwType) :
+// With a standby master the active one is pinged quickly enough to notice an outage within a second
+const unsigned int STANDBY_PING_INTERVAL = 250U;
+const unsigned int MAX_MISSED_PINGS      = 2U;
+
+const unsigned int STATS_INTERVAL = 900U;
+
+const unsigned int NO_MASTER = 99U;
+
+// How far behind the newest packet of a stream a straggler may be and still be used
+const unsigned int SEQ_WINDOW = 32U;
+
+// After a silence this long a packet behind the newest one is the stream jumping ahead, not a straggler
+const unsigned int MAX_SEQ_SILENCE = 1000U;
+
+CDMRNetwork::MASTER::MASTER(const char* name, const std::string& address, unsigned short port, const std::string& password) :
+m_name(name),
 m_addressStr(address),
 m_addr(),
 m_addrLen(0U),
 m_port(port),
-m_id(NULL),
 m_password(password),
+m_status(WAITING_CONNECT),
+m_retryTimer(1000U, 10U),
+m_timeoutTimer(1000U, 60U),
+m_pingTimer(1000U, 10U),
+m_missedPings(0U),
+m_pingWatch(),
+m_pongWatch(),
+m_rtt(),
+m_salt()
+{
+}
+
+CDMRNetwork::CDMRNetwork(const std::string& address, unsigned short port, unsigned int id, const std::string& password, bool duplex, const char* version, bool debug, bool slot1, bool slot2, const char* hwType) :
+m_masterCount(1U),
+m_active(0U),
+m_family(AF_UNSPEC),
+m_id(NULL),
 m_duplex(duplex),
 m_version(version),
 m_debug(debug),
@@ -45,13 +84,20 @@ m_enabled(false),
 m_slot1(slot1),
 m_slot2(slot2),
 m_hwType(hwType),
-m_status(WAITING_CONNECT),
-m_retryTimer(1000U, 10U),
-m_timeoutTimer(1000U, 60U),
+m_tgRanges(),
 m_buffer(NULL),
-m_salt(NULL),
+m_rxMessages(NULL),
+m_txBuffer(NULL),
+m_txMessages(NULL),
+m_txCount(0U),
 m_streamId(NULL),
-m_rxData(1000U, "DMR Network"),
+m_rxWatch(),
+m_rxData1(RX_QUEUE_LENGTH, "DMR Network Slot 1", FQO_DROP_OLDEST),
+m_rxData2(RX_QUEUE_LENGTH, "DMR Network Slot 2", FQO_DROP_OLDEST),
+m_batchTime(0ULL),
+m_statsTimer(1000U, STATS_INTERVAL),
+m_rfLatency(),
+m_residency(),
 m_beacon(false),
 m_random(),
 m_options(),
@@ -72,10 +118,21 @@ m_url()
 	assert(id > 1000U);
 	assert(!password.empty());
 
-	m_buffer   = new unsigned char[BUFFER_LENGTH];
-	m_salt     = new unsigned char[sizeof(uint32_t)];
-	m_id       = new uint8_t[4U];
-	m_streamId = new uint32_t[2U];
+	m_masters[0U] = new MASTER("primary", address, port, password);
+	m_masters[1U] = NULL;
+
+	m_buffer     = new unsigned char[BUFFER_LENGTH * NETWORK_BATCH_SIZE];
+	m_rxMessages = new UDPMessage[NETWORK_BATCH_SIZE];
+	m_txBuffer   = new unsigned char[BUFFER_LENGTH * NETWORK_BATCH_SIZE];
+	m_txMessages = new UDPMessage[NETWORK_BATCH_SIZE];
+
+	for (unsigned int i = 0U; i < NETWORK_BATCH_SIZE; i++) {
+		m_rxMessages[i].buffer = m_buffer + i * BUFFER_LENGTH;
+		m_txMessages[i].buffer = m_txBuffer + i * BUFFER_LENGTH;
+	}
+
+	m_id         = new uint8_t[4U];
+	m_streamId   = new uint32_t[2U];
 
 	m_id[0U] = id >> 24;
 	m_id[1U] = id >> 16;
@@ -89,14 +146,22 @@ m_url()
 	std::uniform_int_distribution<uint32_t> dist(0x00000001, 0xfffffffe);
 	m_streamId[0U] = dist(m_random);
 	m_streamId[1U] = dist(m_random);
+
+	::memset(m_rxStream, 0x00U, sizeof(m_rxStream));
+	m_rxStream[0U].m_master = m_rxStream[1U].m_master = NO_MASTER;
 }
 
 CDMRNetwork::~CDMRNetwork()
 {
 	delete[] m_buffer;
-	delete[] m_salt;
+	delete[] m_rxMessages;
+	delete[] m_txBuffer;
+	delete[] m_txMessages;
 	delete[] m_streamId;
 	delete[] m_id;
+
+	delete m_masters[0U];
+	delete m_masters[1U];
 }
 
 void CDMRNetwork::setOptions(const std::string& options)
@@ -104,6 +169,30 @@ void CDMRNetwork::setOptions(const std::string& options)
 	m_options = options;
 }
 
+void CDMRNetwork::setSecondary(const std::string& address, unsigned short port, const std::string& password)
+{
+	assert(!address.empty());
+	assert(port > 0U);
+	assert(!password.empty());
+
+	delete m_masters[1U];
+	m_masters[1U] = new MASTER("secondary", address, port, password);
+	m_masterCount = 2U;
+
+	for (unsigned int i = 0U; i < m_masterCount; i++)
+		m_masters[i]->m_pingTimer.setTimeout(0U, STANDBY_PING_INTERVAL);
+}
+
+void CDMRNetwork::setTGRanges(const std::vector<std::pair<unsigned int, unsigned int>>& ranges)
+{
+	m_tgRanges = ranges;
+}
+
+void CDMRNetwork::setSocketOptions(unsigned int rxBuffer, unsigned int txBuffer, unsigned int dscp, unsigned int priority, unsigned int busyPoll)
+{
+	m_socket.setOptions(rxBuffer, txBuffer, dscp, priority, busyPoll);
+}
+
 void CDMRNetwork::setConfig(const std::string& callsign, unsigned int rxFrequency, unsigned int txFrequency, unsigned int power, unsigned int colorCode, float latitude, float longitude, int height, const std::string& location, const std::string& description, const std::string& url)
 {
 	m_callsign    = callsign;
@@ -123,90 +212,114 @@ bool CDMRNetwork::open()
 {
 	LogMessage("DMR, Opening DMR Network");
 
-	CUDPSocket::lookup(m_addressStr, m_port, m_addr, m_addrLen);
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		MASTER& master = *m_masters[i];
+
+		// Until the resolver has an answer the master stays waiting to connect
+		CDNSResolver::lookup(master.m_addressStr, master.m_port, master.m_addr, master.m_addrLen);
+
+		master.m_status      = WAITING_CONNECT;
+		master.m_missedPings = 0U;
+		master.m_timeoutTimer.start();
+		master.m_retryTimer.start();
+		master.m_pingTimer.stop();
+	}
+
+	m_txCount = 0U;
+	m_active  = 0U;
+
+	m_statsTimer.start();
 
-	m_status = WAITING_CONNECT;
-	m_timeoutTimer.start();
-	m_retryTimer.start();
+	m_rxStream[0U].m_master = m_rxStream[1U].m_master = NO_MASTER;
 
 	return true;
 }
 
 void CDMRNetwork::enable(bool enabled)
 {
-	if (!enabled && m_enabled)
-		m_rxData.clear();
+	if (!enabled && m_enabled) {
+		m_rxData1.clear();
+		m_rxData2.clear();
+	}
 
 	m_enabled = enabled;
 }
 
-bool CDMRNetwork::read(CDMRData& data)
+bool CDMRNetwork::routes(unsigned int slotNo, FLCO flco, unsigned int dstId) const
 {
-	if (m_status != RUNNING)
+	// DMO mode slot disabling
+	if (slotNo == 1U && !m_duplex)
 		return false;
 
-	if (m_rxData.isEmpty())
+	// Individual slot disabling
+	if (slotNo == 1U && !m_slot1)
 		return false;
-
-	unsigned char length = 0U;
-	m_rxData.getData(&length, 1U);
-	m_rxData.getData(m_buffer, length);
-
-	// Is this a data packet?
-	if (::memcmp(m_buffer, "DMRD", 4U) != 0)
+	if (slotNo == 2U && !m_slot2)
 		return false;
 
-	unsigned char seqNo = m_buffer[4U];
+	// Talkgroup ranges only narrow down group calls
+	if (flco != FLCO_GROUP || m_tgRanges.empty())
+		return true;
 
-	unsigned int srcId = (m_buffer[5U] << 16) | (m_buffer[6U] << 8) | (m_buffer[7U] << 0);
+	for (std::vector<std::pair<unsigned int, unsigned int>>::const_iterator it = m_tgRanges.begin(); it != m_tgRanges.end(); ++it) {
+		if (dstId >= it->first && dstId <= it->second)
+			return true;
+	}
 
-	unsigned int dstId = (m_buffer[8U] << 16) | (m_buffer[9U] << 8) | (m_buffer[10U] << 0);
+	return false;
+}
 
-	unsigned int slotNo = (m_buffer[15U] & 0x80U) == 0x80U ? 2U : 1U;
+bool CDMRNetwork::isRunning() const
+{
+	return m_masters[m_active]->m_status == RUNNING;
+}
 
-	// DMO mode slot disabling
-	if (slotNo == 1U && !m_duplex)
-		return false;
+bool CDMRNetwork::read(unsigned int slotNo, CDMRData& data)
+{
+	assert(slotNo == 1U || slotNo == 2U);
 
-	// Individual slot disabling
-	if (slotNo == 1U && !m_slot1)
+	if (!isRunning())
 		return false;
-	if (slotNo == 2U && !m_slot2)
+
+	CFrameQueue& queue = slotNo == 1U ? m_rxData1 : m_rxData2;
+
+	unsigned int length = 0U;
+	const unsigned char* buffer = queue.peek(length);
+	if (buffer == NULL)
 		return false;
 
-	FLCO flco = (m_buffer[15U] & 0x40U) == 0x40U ? FLCO_USER_USER : FLCO_GROUP;
+	assert(length == sizeof(NET_FRAME));
 
-	data.setSeqNo(seqNo);
-	data.setSlotNo(slotNo);
-	data.setSrcId(srcId);
-	data.setDstId(dstId);
-	data.setFLCO(flco);
+	// The packet was checked and decoded when it arrived
+	NET_FRAME frame;
+	::memcpy(&frame, buffer, sizeof(NET_FRAME));
 
-	bool dataSync = (m_buffer[15U] & 0x20U) == 0x20U;
-	bool voiceSync = (m_buffer[15U] & 0x10U) == 0x10U;
+	queue.pop();
 
-	if (dataSync) {
-		unsigned char dataType = m_buffer[15U] & 0x0FU;
-		data.setData(m_buffer + 20U);
-		data.setDataType(dataType);
-		data.setN(0U);
-	} else if (voiceSync) {
-		data.setData(m_buffer + 20U);
-		data.setDataType(DT_VOICE_SYNC);
-		data.setN(0U);
-	} else {
-		unsigned char n = m_buffer[15U] & 0x0FU;
-		data.setData(m_buffer + 20U);
-		data.setDataType(DT_VOICE);
-		data.setN(n);
-	}
+	m_residency.addSample(frame.queued);
+
+	data.setSeqNo(frame.seqNo);
+	data.setSlotNo(frame.slotNo);
+	data.setSrcId(frame.srcId);
+	data.setDstId(frame.dstId);
+	data.setFLCO(frame.flco);
+	data.setStreamId(frame.streamId);
+	data.setDataType(frame.dataType);
+	data.setN(frame.n);
+	data.setData(frame.data);
+	data.setTimestamp(frame.timestamp);
 
 	return true;
 }
 
+bool CDMRNetwork::hasData() const
+{
+	return isRunning() && (!m_rxData1.isEmpty() || !m_rxData2.isEmpty());
+}
+
 bool CDMRNetwork::write(const CDMRData& data)
 {
-	if (m_status != RUNNING)
+	if (!isRunning())
 		return false;
 
 	unsigned char buffer[HOMEBREW_DATA_PACKET_LENGTH];
@@ -273,14 +386,14 @@ bool CDMRNetwork::write(const CDMRData& data)
 	if (m_debug)
 		CUtils::dump(1U, "Network Transmitted", buffer, HOMEBREW_DATA_PACKET_LENGTH);
 
-	write(buffer, HOMEBREW_DATA_PACKET_LENGTH);
+	write(*m_masters[m_active], buffer, HOMEBREW_DATA_PACKET_LENGTH, data.getTimestamp());
 
 	return true;
 }
 
 bool CDMRNetwork::writeRadioPosition(unsigned int id, const unsigned char* data)
 {
-	if (m_status != RUNNING)
+	if (!isRunning())
 		return false;
 
 	unsigned char buffer[20U];
@@ -295,12 +408,12 @@ bool CDMRNetwork::writeRadioPosition(unsigned int id, const unsigned char* data)
 
 	::memcpy(buffer + 11U, data + 2U, 7U);
 
-	return write(buffer, 18U);
+	return write(*m_masters[m_active], buffer, 18U);
 }
 
 bool CDMRNetwork::writeTalkerAlias(unsigned int id, unsigned char type, const unsigned char* data)
 {
-	if (m_status != RUNNING)
+	if (!isRunning())
 		return false;
 
 	unsigned char buffer[20U];
@@ -317,177 +430,551 @@ bool CDMRNetwork::writeTalkerAlias(unsigned int id, unsigned char type, const un
 
 	::memcpy(buffer + 12U, data + 2U, 7U);
 
-	return write(buffer, 19U);
+	return write(*m_masters[m_active], buffer, 19U);
 }
 
 void CDMRNetwork::close()
 {
 	LogMessage("DMR, Closing DMR Network");
 
-	if (m_status == RUNNING) {
-		unsigned char buffer[9U];
-		::memcpy(buffer + 0U, "RPTCL", 5U);
-		::memcpy(buffer + 5U, m_id, 4U);
-		write(buffer, 9U);
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		MASTER& master = *m_masters[i];
+
+		if (master.m_status == RUNNING) {
+			unsigned char buffer[9U];
+			::memcpy(buffer + 0U, "RPTCL", 5U);
+			::memcpy(buffer + 5U, m_id, 4U);
+			write(master, buffer, 9U);
+		}
 	}
 
+	flush();
+
 	m_socket.close();
 
-	m_retryTimer.stop();
-	m_timeoutTimer.stop();
+	m_rxData1.logStats();
+	m_rxData2.logStats();
+	logStats();
+
+	m_statsTimer.stop();
+
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		m_masters[i]->m_retryTimer.stop();
+		m_masters[i]->m_timeoutTimer.stop();
+		m_masters[i]->m_pingTimer.stop();
+	}
 }
 
 void CDMRNetwork::clock(unsigned int ms)
 {
-	m_retryTimer.clock(ms);
-	if (m_retryTimer.isRunning() && m_retryTimer.hasExpired()) {
-		switch (m_status) {
+	for (unsigned int i = 0U; i < m_masterCount; i++)
+		clockMaster(i, ms);
+
+	// Take everything the masters have sent since the last pass
+	for (;;) {
+		int count = m_socket.read(m_rxMessages, NETWORK_BATCH_SIZE, BUFFER_LENGTH);
+		if (count < 0) {
+			LogError("DMR, Socket has failed, retrying connection to the master");
+			close();
+			open();
+			return;
+		}
+
+		// One clock read covers the batch for the queue residency times
+		if (count > 0)
+			m_batchTime = CLatencyStats::now();
+
+		for (int i = 0; i < count; i++)
+			processPacket(m_rxMessages[i]);
+
+		if (count < int(NETWORK_BATCH_SIZE))
+			break;
+	}
+
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		MASTER& master = *m_masters[i];
+
+		master.m_timeoutTimer.clock(ms);
+		if (master.m_timeoutTimer.isRunning() && master.m_timeoutTimer.hasExpired()) {
+			LogError("DMR, Connection to the %s master has timed out, retrying connection", master.m_name);
+			resetMaster(i, true);
+		}
+	}
+
+	selectActive();
+
+	m_statsTimer.clock(ms);
+	if (m_statsTimer.isRunning() && m_statsTimer.hasExpired()) {
+		logStats();
+		m_statsTimer.start();
+	}
+}
+
+void CDMRNetwork::logStats() const
+{
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		char name[40U];
+		::sprintf(name, "DMR, %s master", m_masters[i]->m_name);
+		m_masters[i]->m_rtt.logStats(name);
+	}
+
+	m_rfLatency.logStats("DMR, RF to network");
+	m_residency.logStats("DMR, network queue residency");
+
+	for (unsigned int i = 0U; i < 2U; i++) {
+		if (m_rxStream[i].m_duplicates > 0U || m_rxStream[i].m_late > 0U)
+			LogMessage("DMR, Slot %u, %u duplicate and %u late packets discarded", i + 1U, m_rxStream[i].m_duplicates, m_rxStream[i].m_late);
+	}
+
+	unsigned int drops = m_socket.getDrops();
+	if (drops > 0U)
+		LogWarning("DMR, %u datagrams dropped by the kernel for want of receive buffer space", drops);
+}
+
+void CDMRNetwork::clockMaster(unsigned int index, unsigned int ms)
+{
+	MASTER& master = *m_masters[index];
+
+	master.m_retryTimer.clock(ms);
+	if (master.m_retryTimer.isRunning() && master.m_retryTimer.hasExpired()) {
+		switch (master.m_status) {
 			case WAITING_CONNECT:
-				if (m_socket.open(m_addr.ss_family)) {
-					if (writeLogin()) {
-						m_status = WAITING_LOGIN;
-					}
+				if (!CDNSResolver::lookup(master.m_addressStr, master.m_port, master.m_addr, master.m_addrLen))
+					break;
+
+				// Both masters share the one socket
+				if (m_socket.getFd() >= 0 && master.m_addr.ss_family != m_family) {
+					LogError("DMR, The secondary master uses a different address family to the primary, ignoring it");
+					m_masterCount = 1U;
+					m_active      = 0U;
+					if (index > 0U)
+						break;
+					m_socket.close();
 				}
+
+				if (m_socket.getFd() < 0) {
+					if (!m_socket.open(master.m_addr.ss_family))
+						break;
+					m_family = master.m_addr.ss_family;
+				}
+
+				if (writeLogin(master))
+					master.m_status = WAITING_LOGIN;
 				break;
 			case WAITING_LOGIN:
-				writeLogin();
+				// Pick up a changed address from the resolver before logging in again
+				CDNSResolver::lookup(master.m_addressStr, master.m_port, master.m_addr, master.m_addrLen);
+				writeLogin(master);
 				break;
 			case WAITING_AUTHORISATION:
-				writeAuthorisation();
+				writeAuthorisation(master);
 				break;
 			case WAITING_OPTIONS:
-				writeOptions();
+				writeOptions(master);
 				break;
 			case WAITING_CONFIG:
-				writeConfig();
-				break;
-			case RUNNING:
-				writePing();
+				writeConfig(master);
 				break;
 			default:
 				break;
 		}
-		m_retryTimer.start();
+		master.m_retryTimer.start();
 	}
 
-	sockaddr_storage address;
-	unsigned int addrlen;
-	int length = m_socket.read(m_buffer, BUFFER_LENGTH, address, addrlen);
-	if (length < 0) {
-		LogError("DMR, Socket has failed, retrying connection to the master");
-		close();
-		open();
-		return;
+	master.m_pingTimer.clock(ms);
+	if (master.m_pingTimer.isRunning() && master.m_pingTimer.hasExpired()) {
+		// Every ping still unanswered when the next one is due counts as missed
+		if (master.m_missedPings++ > 0U)
+			master.m_rtt.addMissed();
+
+		master.m_pingWatch.start();
+		writePing(master);
+		master.m_pingTimer.start();
 	}
+}
 
-	if (length > 0) {
-		// should never happen
-		if (!CUDPSocket::match(m_addr, address)) {
-			LogMessage("DMR, packet received from an invalid source");
+void CDMRNetwork::resetMaster(unsigned int index, bool reconnect)
+{
+	MASTER& master = *m_masters[index];
+
+	// The master may have moved, have its name resolved again in the background
+	CDNSResolver::refresh(master.m_addressStr, master.m_port);
+
+	// Without a standby the socket is this master's alone, so when the link itself may be at fault start
+	// again on a new source port in case the old one is what stopped working. With a standby the shared
+	// socket is kept for the other master. A master that only refused us while running gets a new login.
+	if (reconnect && m_masterCount == 1U) {
+		m_txCount = 0U;
+		m_socket.close();
+
+		master.m_status = WAITING_CONNECT;
+	} else {
+		master.m_status = WAITING_LOGIN;
+	}
+
+	master.m_missedPings = 0U;
+	master.m_timeoutTimer.start();
+	master.m_retryTimer.start();
+	master.m_pingTimer.stop();
+}
+
+bool CDMRNetwork::isHealthy(MASTER& master) const
+{
+	if (master.m_status != RUNNING)
+		return false;
+
+	if (master.m_missedPings == 0U)
+		return true;
+
+	// A slow link is given longer to answer before the master is given up on
+	return master.m_pongWatch.elapsed() <= MAX_MISSED_PINGS * STANDBY_PING_INTERVAL + master.m_rtt.getRTO();
+}
+
+void CDMRNetwork::selectActive()
+{
+	MASTER& active = *m_masters[m_active];
+	if (isHealthy(active))
+		return;
+
+	// Stay with the current master until it fails, rather than flapping back to the primary
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		MASTER& master = *m_masters[i];
+
+		if (i != m_active && isHealthy(master)) {
+			LogWarning("DMR, Switching from the %s master to the %s master", active.m_name, master.m_name);
+			m_active = i;
 			return;
 		}
+	}
+}
+
+bool CDMRNetwork::processPacket(const UDPMessage& message)
+{
+	for (unsigned int i = 0U; i < m_masterCount; i++) {
+		if (CUDPSocket::match(m_masters[i]->m_addr, message.address))
+			return processData(i, message);
+	}
 
-		if (m_debug)
-			CUtils::dump(1U, "Network Received", m_buffer, length);
+	// should never happen
+	LogMessage("DMR, packet received from an invalid source");
 
-		if (::memcmp(m_buffer, "DMRD", 4U) == 0) {
-			if (m_enabled) {
-				unsigned char len = length;
-				m_rxData.addData(&len, 1U);
-				m_rxData.addData(m_buffer, len);
+	return false;
+}
+
+CDMRNetwork::PACKET_TYPE CDMRNetwork::classify(const unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+
+	// The first and fourth bytes are enough to tell the tags from the master apart, one compare then confirms it
+	if (length < 5U)
+		return PT_UNKNOWN;
+
+	switch (buffer[0U]) {
+		case 'D':
+			return ::memcmp(buffer, "DMRD", 4U) == 0 ? PT_DMRD : PT_UNKNOWN;
+		case 'M':
+			switch (buffer[3U]) {
+				case 'P':
+					return (length >= 7U && ::memcmp(buffer, "MSTPONG", 7U) == 0) ? PT_MSTPONG : PT_UNKNOWN;
+				case 'N':
+					return (length >= 6U && ::memcmp(buffer, "MSTNAK", 6U) == 0) ? PT_MSTNAK : PT_UNKNOWN;
+				case 'C':
+					return ::memcmp(buffer, "MSTCL", 5U) == 0 ? PT_MSTCL : PT_UNKNOWN;
+				default:
+					return PT_UNKNOWN;
 			}
-		} else if (::memcmp(m_buffer, "MSTNAK",  6U) == 0) {
-			if (m_status == RUNNING) {
-				LogWarning("DMR, Login to the master has failed, retrying login ...");
-				m_status = WAITING_LOGIN;
-				m_timeoutTimer.start();
-				m_retryTimer.start();
-			} else {
-				/* Once the modem death spiral has been prevented in Modem.cpp
-				   the Network sometimes times out and reaches here.
-				   We want it to reconnect so... */
-				LogError("DMR, Login to the master has failed, retrying network ...");
-				close();
-				open();
-				return;
+		case 'R':
+			switch (buffer[3U]) {
+				case 'A':
+					return (length >= 6U && ::memcmp(buffer, "RPTACK", 6U) == 0) ? PT_RPTACK : PT_UNKNOWN;
+				case 'S':
+					return (length >= 7U && ::memcmp(buffer, "RPTSBKN", 7U) == 0) ? PT_RPTSBKN : PT_UNKNOWN;
+				default:
+					return PT_UNKNOWN;
 			}
-		} else if (::memcmp(m_buffer, "RPTACK",  6U) == 0) {
-			switch (m_status) {
+		default:
+			return PT_UNKNOWN;
+	}
+}
+
+void CDMRNetwork::processDMRD(unsigned int index, const UDPMessage& message)
+{
+	const unsigned char* buffer = message.buffer;
+
+	if (!m_enabled || message.length < HOMEBREW_DATA_PACKET_LENGTH)
+		return;
+
+	unsigned int slotIndex = (buffer[15U] & 0x80U) == 0x80U ? 1U : 0U;
+	uint32_t streamId = (buffer[16U] << 24) | (buffer[17U] << 16) | (buffer[18U] << 8) | (buffer[19U] << 0);
+
+	RX_STREAM& stream = m_rxStream[slotIndex];
+
+	// While both masters are up a stream may arrive twice, keep the copy from the master it started on
+	// until the active master takes it over, and only start new streams from the active master
+	if (streamId == stream.m_streamId) {
+		if (index != stream.m_master) {
+			if (index != m_active)
+				return;
+			stream.m_master = index;
+		}
+	} else if (index != m_active) {
+		return;
+	}
+
+	if (!checkSeqNo(stream, streamId, buffer[4U]))
+		return;
+
+	stream.m_master = index;
+
+	NET_FRAME frame;
+	frame.slotNo = slotIndex + 1U;
+	frame.flco   = (buffer[15U] & 0x40U) == 0x40U ? FLCO_USER_USER : FLCO_GROUP;
+	frame.dstId  = (buffer[8U] << 16) | (buffer[9U] << 8) | (buffer[10U] << 0);
+
+	if (!routes(frame.slotNo, frame.flco, frame.dstId))
+		return;
+
+	frame.timestamp = message.timestamp;
+	frame.queued    = m_batchTime;
+	frame.srcId     = (buffer[5U] << 16) | (buffer[6U] << 8) | (buffer[7U] << 0);
+	frame.streamId  = streamId;
+	frame.seqNo     = buffer[4U];
+
+	bool dataSync  = (buffer[15U] & 0x20U) == 0x20U;
+	bool voiceSync = (buffer[15U] & 0x10U) == 0x10U;
+
+	if (dataSync) {
+		frame.dataType = buffer[15U] & 0x0FU;
+		frame.n        = 0U;
+	} else if (voiceSync) {
+		frame.dataType = DT_VOICE_SYNC;
+		frame.n        = 0U;
+	} else {
+		frame.dataType = DT_VOICE;
+		frame.n        = buffer[15U] & 0x0FU;
+	}
+
+	::memcpy(frame.data, buffer + 20U, DMR_FRAME_LENGTH_BYTES);
+
+	// Each slot has its own queue so that the control layer can share its time between them
+	if (slotIndex == 0U)
+		m_rxData1.addData((unsigned char*)&frame, sizeof(NET_FRAME));
+	else
+		m_rxData2.addData((unsigned char*)&frame, sizeof(NET_FRAME));
+}
+
+bool CDMRNetwork::checkSeqNo(RX_STREAM& stream, uint32_t streamId, unsigned char seqNo)
+{
+	unsigned long long now = m_rxWatch.time();
+
+	if (streamId != stream.m_streamId) {
+		// The tail of the previous stream turning up after the next has begun
+		if (streamId == stream.m_lastStreamId) {
+			stream.m_late++;
+			return false;
+		}
+
+		stream.m_lastStreamId = stream.m_streamId;
+		stream.m_streamId     = streamId;
+		stream.m_seqNo        = seqNo;
+		stream.m_window       = 0x00000001U;
+		stream.m_lastArrival  = now;
+		return true;
+	}
+
+	unsigned long long silence = now - stream.m_lastArrival;
+	stream.m_lastArrival = now;
+
+	// Sequence numbers wrap at 256, so take the distance from the newest one modulo that
+	int delta = int((unsigned char)(seqNo - stream.m_seqNo));
+	if (delta >= 128)
+		delta -= 256;
+
+	if (delta > 0) {
+		stream.m_window = (unsigned int)delta < SEQ_WINDOW ? (stream.m_window << delta) | 0x00000001U : 0x00000001U;
+		stream.m_seqNo  = seqNo;
+		return true;
+	}
+
+	// Too far behind, or after too long a silence, to be a straggler, so the stream has jumped ahead
+	// and the window starts again from here
+	unsigned int behind = (unsigned int)-delta;
+	if (behind >= SEQ_WINDOW || (behind > 0U && silence > MAX_SEQ_SILENCE)) {
+		stream.m_seqNo  = seqNo;
+		stream.m_window = 0x00000001U;
+		return true;
+	}
+
+	uint32_t bit = 0x00000001U << behind;
+	if ((stream.m_window & bit) != 0U) {
+		stream.m_duplicates++;
+		return false;
+	}
+
+	stream.m_window |= bit;
+
+	return true;
+}
+
+bool CDMRNetwork::processData(unsigned int index, const UDPMessage& message)
+{
+	MASTER& master = *m_masters[index];
+
+	if (m_debug)
+		CUtils::dump(1U, "Network Received", message.buffer, message.length);
+
+	switch (classify(message.buffer, message.length)) {
+		case PT_DMRD:
+			processDMRD(index, message);
+			break;
+
+		case PT_MSTNAK:
+			if (master.m_status == RUNNING)
+				LogWarning("DMR, Login to the %s master has failed, retrying login ...", master.m_name);
+			else
+				LogError("DMR, Login to the %s master has failed, retrying network ...", master.m_name);
+			resetMaster(index, master.m_status != RUNNING);
+			break;
+
+		case PT_RPTACK:
+			switch (master.m_status) {
 				case WAITING_LOGIN:
-					LogDebug("DMR, Sending authorisation");
-					::memcpy(m_salt, m_buffer + 6U, sizeof(uint32_t));
-					writeAuthorisation();
-					m_status = WAITING_AUTHORISATION;
-					m_timeoutTimer.start();
-					m_retryTimer.start();
+					LogDebug("DMR, Sending authorisation to the %s master", master.m_name);
+					::memcpy(master.m_salt, message.buffer + 6U, sizeof(uint32_t));
+					writeAuthorisation(master);
+					master.m_status = WAITING_AUTHORISATION;
+					master.m_timeoutTimer.start();
+					master.m_retryTimer.start();
 					break;
 				case WAITING_AUTHORISATION:
-					LogDebug("DMR, Sending configuration");
-					writeConfig();
-					m_status = WAITING_CONFIG;
-					m_timeoutTimer.start();
-					m_retryTimer.start();
+					LogDebug("DMR, Sending configuration to the %s master", master.m_name);
+					writeConfig(master);
+					master.m_status = WAITING_CONFIG;
+					master.m_timeoutTimer.start();
+					master.m_retryTimer.start();
 					break;
 				case WAITING_CONFIG:
 					if (m_options.empty()) {
-						LogMessage("DMR, Logged into the master successfully");
-						m_status = RUNNING;
+						LogMessage("DMR, Logged into the %s master successfully", master.m_name);
+						master.m_status = RUNNING;
+						master.m_retryTimer.stop();
+						master.m_pingTimer.start();
+						master.m_pongWatch.start();
 					} else {
-						LogDebug("DMR, Sending options");
-						writeOptions();
-						m_status = WAITING_OPTIONS;
+						LogDebug("DMR, Sending options to the %s master", master.m_name);
+						writeOptions(master);
+						master.m_status = WAITING_OPTIONS;
+						master.m_retryTimer.start();
 					}
-					m_timeoutTimer.start();
-					m_retryTimer.start();
+					master.m_timeoutTimer.start();
 					break;
 				case WAITING_OPTIONS:
-					LogMessage("DMR, Logged into the master successfully");
-					m_status = RUNNING;
-					m_timeoutTimer.start();
-					m_retryTimer.start();
+					LogMessage("DMR, Logged into the %s master successfully", master.m_name);
+					master.m_status = RUNNING;
+					master.m_timeoutTimer.start();
+					master.m_retryTimer.stop();
+					master.m_pingTimer.start();
+					master.m_pongWatch.start();
 					break;
 				default:
 					break;
 			}
-		} else if (::memcmp(m_buffer, "MSTCL",   5U) == 0) {
-			LogError("DMR, Master is closing down");
-			close();
-			open();
-		} else if (::memcmp(m_buffer, "MSTPONG", 7U) == 0) {
-			m_timeoutTimer.start();
-		} else if (::memcmp(m_buffer, "RPTSBKN", 7U) == 0) {
-			m_beacon = true;
-		} else {
-			CUtils::dump("Unknown packet from the master", m_buffer, length);
-		}
+			break;
+
+		case PT_MSTCL:
+			LogError("DMR, The %s master is closing down", master.m_name);
+			resetMaster(index, true);
+			break;
+
+		case PT_MSTPONG:
+			// Pongs carry nothing to match them to a ping, so only time one when a single ping is outstanding
+			if (master.m_missedPings == 1U)
+				master.m_rtt.addSample(master.m_pingWatch.elapsed());
+
+			master.m_missedPings = 0U;
+			master.m_pongWatch.start();
+			master.m_timeoutTimer.start();
+			break;
+
+		case PT_RPTSBKN:
+			// Only the master carrying our traffic gets to key up the beacon
+			if (index == m_active)
+				m_beacon = true;
+			break;
+
+		default:
+			CUtils::dump("Unknown packet from the master", message.buffer, message.length);
+			break;
 	}
 
-	m_timeoutTimer.clock(ms);
-	if (m_timeoutTimer.isRunning() && m_timeoutTimer.hasExpired()) {
-		LogError("DMR, Connection to the master has timed out, retrying connection");
-		close();
-		open();
+	return true;
+}
+
+void CDMRNetwork::flush()
+{
+	if (m_txCount == 0U)
+		return;
+
+	unsigned int count = m_txCount;
+	m_txCount = 0U;
+
+	unsigned int offset = 0U;
+	for (;;) {
+		unsigned int sent = m_socket.write(m_txMessages + offset, count - offset);
+		for (unsigned int i = offset; i < offset + sent; i++)
+			m_rfLatency.addSample(m_txMessages[i].timestamp);
+
+		offset += sent;
+		if (offset >= count)
+			return;
+
+		// Only the master the failed datagram was for starts again, the other keeps its session
+		unsigned int index = 0U;
+		for (unsigned int i = 0U; i < m_masterCount; i++) {
+			if (CUDPSocket::match(m_masters[i]->m_addr, m_txMessages[offset].address))
+				index = i;
+		}
+
+		MASTER& master = *m_masters[index];
+		LogError("DMR, Socket has failed when writing data to the %s master, retrying connection", master.m_name);
+		resetMaster(index, true);
+
+		// Whatever else was queued for that master belonged to the old session, swapping keeps each buffer in use once
+		unsigned int kept = offset;
+		for (unsigned int i = offset + 1U; i < count; i++) {
+			if (!CUDPSocket::match(master.m_addr, m_txMessages[i].address))
+				std::swap(m_txMessages[kept++], m_txMessages[i]);
+		}
+
+		count = kept;
+		if (offset >= count)
+			return;
 	}
 }
 
-bool CDMRNetwork::writeLogin()
+int CDMRNetwork::getFd() const
+{
+	return m_socket.getFd();
+}
+
+bool CDMRNetwork::writeLogin(MASTER& master)
 {
 	unsigned char buffer[8U];
 
 	::memcpy(buffer + 0U, "RPTL", 4U);
 	::memcpy(buffer + 4U, m_id, 4U);
 
-	return write(buffer, 8U);
+	return write(master, buffer, 8U);
 }
 
-bool CDMRNetwork::writeAuthorisation()
+bool CDMRNetwork::writeAuthorisation(MASTER& master)
 {
-	size_t size = m_password.size();
+	size_t size = master.m_password.size();
 
 	unsigned char* in = new unsigned char[size + sizeof(uint32_t)];
-	::memcpy(in, m_salt, sizeof(uint32_t));
+	::memcpy(in, master.m_salt, sizeof(uint32_t));
 	for (size_t i = 0U; i < size; i++)
-		in[i + sizeof(uint32_t)] = m_password.at(i);
+		in[i + sizeof(uint32_t)] = master.m_password.at(i);
 
 	unsigned char out[40U];
 	::memcpy(out + 0U, "RPTK", 4U);
@@ -498,10 +985,10 @@ bool CDMRNetwork::writeAuthorisation()
 
 	delete[] in;
 
-	return write(out, 40U);
+	return write(master, out, 40U);
 }
 
-bool CDMRNetwork::writeOptions()
+bool CDMRNetwork::writeOptions(MASTER& master)
 {
 	char buffer[300U];
 
@@ -509,10 +996,10 @@ bool CDMRNetwork::writeOptions()
 	::memcpy(buffer + 4U, m_id, 4U);
 	::strcpy(buffer + 8U, m_options.c_str());
 
-	return write((unsigned char*)buffer, (unsigned int)m_options.length() + 8U);
+	return write(master, (unsigned char*)buffer, (unsigned int)m_options.length() + 8U);
 }
 
-bool CDMRNetwork::writeConfig()
+bool CDMRNetwork::writeConfig(MASTER& master)
 {
 	char slots = '0';
 	if (m_duplex) {
@@ -550,17 +1037,17 @@ bool CDMRNetwork::writeConfig()
 		m_rxFrequency, m_txFrequency, power, m_colorCode, latitude, longitude, height, m_location.c_str(),
 		m_description.c_str(), slots, m_url.c_str(), m_version, m_hwType);
 
-	return write((unsigned char*)buffer, 302U);
+	return write(master, (unsigned char*)buffer, 302U);
 }
 
-bool CDMRNetwork::writePing()
+bool CDMRNetwork::writePing(MASTER& master)
 {
 	unsigned char buffer[11U];
 
 	::memcpy(buffer + 0U, "RPTPING", 7U);
 	::memcpy(buffer + 7U, m_id, 4U);
 
-	return write(buffer, 11U);
+	return write(master, buffer, 11U);
 }
 
 bool CDMRNetwork::wantsBeacon()
@@ -572,18 +1059,22 @@ bool CDMRNetwork::wantsBeacon()
 	return beacon;
 }
 
-bool CDMRNetwork::write(const unsigned char* data, unsigned int length)
+bool CDMRNetwork::write(MASTER& master, const unsigned char* data, unsigned int length, unsigned long long timestamp)
 {
 	assert(data != NULL);
 	assert(length > 0U);
-
-	bool ret = m_socket.write(data, length, m_addr, m_addrLen);
-	if (!ret) {
-		LogError("DMR, Socket has failed when writing data to the master, retrying connection");
-		m_socket.close();
-		open();
-		return false;
-	}
+	assert(length <= BUFFER_LENGTH);
+
+	// Packets are held until flush() so that a pass through the main loop goes out in one call
+	if (m_txCount == NETWORK_BATCH_SIZE)
+		flush();
+
+	UDPMessage& message = m_txMessages[m_txCount++];
+	::memcpy(message.buffer, data, length);
+	message.length        = length;
+	message.address       = master.m_addr;
+	message.addressLength = master.m_addrLen;
+	message.timestamp     = timestamp;
 
 	if (m_debug)
 		CUtils::dump(1U, "Network Transmitted", data, length);
@@ -20,11 +20,16 @@
 
 #include "UDPSocket.h"
 #include "Timer.h"
-#include "RingBuffer.h"
+#include "FrameQueue.h"
+#include "StopWatch.h"
+#include "RTTStats.h"
+#include "LatencyStats.h"
 #include "DMRData.h"
 #include "Defines.h"
 
 #include <string>
+#include <vector>
+#include <utility>
 #include <cstdint>
 #include <random>
 
@@ -36,13 +41,24 @@ public:
 
 	void setOptions(const std::string& options);
 
+	void setSecondary(const std::string& address, unsigned short port, const std::string& password);
+
+	void setTGRanges(const std::vector<std::pair<unsigned int, unsigned int>>& ranges);
+
+	void setSocketOptions(unsigned int rxBuffer, unsigned int txBuffer, unsigned int dscp, unsigned int priority, unsigned int busyPoll);
+
 	void setConfig(const std::string& callsign, unsigned int rxFrequency, unsigned int txFrequency, unsigned int power, unsigned int colorCode, float latitude, float longitude, int height, const std::string& location, const std::string& description, const std::string& url);
 
 	bool open();
 
+	// Whether traffic for this slot and destination belongs to this session
+	bool routes(unsigned int slotNo, FLCO flco, unsigned int dstId) const;
+
 	void enable(bool enabled);
 
-	bool read(CDMRData& data);
+	bool read(unsigned int slotNo, CDMRData& data);
+
+	bool hasData() const;
 
 	bool write(const CDMRData& data);
 
@@ -54,15 +70,85 @@ public:
 
 	void clock(unsigned int ms);
 
+	void flush();
+
+	int  getFd() const;
+
 	void close();
 
 private: 
-	std::string      m_addressStr;
-	sockaddr_storage m_addr;
-	unsigned int     m_addrLen;
-	unsigned short   m_port;
+	enum STATUS {
+		WAITING_CONNECT,
+		WAITING_LOGIN,
+		WAITING_AUTHORISATION,
+		WAITING_CONFIG,
+		WAITING_OPTIONS,
+		RUNNING
+	};
+
+	enum PACKET_TYPE {
+		PT_DMRD,
+		PT_MSTNAK,
+		PT_RPTACK,
+		PT_MSTCL,
+		PT_MSTPONG,
+		PT_RPTSBKN,
+		PT_UNKNOWN
+	};
+
+	// The stream being received on one slot, with a window of the sequence numbers already seen
+	struct RX_STREAM {
+		uint32_t         m_streamId;
+		uint32_t         m_lastStreamId;
+		unsigned int     m_master;
+		unsigned char    m_seqNo;
+		uint32_t         m_window;
+		unsigned long long m_lastArrival;
+		unsigned int     m_duplicates;
+		unsigned int     m_late;
+	};
+
+	// A DMRD packet decoded on arrival, as held in the receive queue
+	struct NET_FRAME {
+		unsigned long long timestamp;
+		unsigned long long queued;
+		unsigned int       srcId;
+		unsigned int       dstId;
+		unsigned int       streamId;
+		unsigned int       slotNo;
+		FLCO               flco;
+		unsigned char      seqNo;
+		unsigned char      dataType;
+		unsigned char      n;
+		unsigned char      data[DMR_FRAME_LENGTH_BYTES];
+	};
+
+	// One Homebrew login, a second one is kept running as a hot standby when configured
+	struct MASTER {
+		MASTER(const char* name, const std::string& address, unsigned short port, const std::string& password);
+
+		const char*      m_name;
+		std::string      m_addressStr;
+		sockaddr_storage m_addr;
+		unsigned int     m_addrLen;
+		unsigned short   m_port;
+		std::string      m_password;
+		STATUS           m_status;
+		CTimer           m_retryTimer;
+		CTimer           m_timeoutTimer;
+		CTimer           m_pingTimer;
+		unsigned int     m_missedPings;
+		CStopWatch       m_pingWatch;
+		CStopWatch       m_pongWatch;
+		CRTTStats        m_rtt;
+		unsigned char    m_salt[sizeof(uint32_t)];
+	};
+
+	MASTER*          m_masters[2U];
+	unsigned int     m_masterCount;
+	unsigned int     m_active;
+	unsigned int     m_family;
 	uint8_t*         m_id;
-	std::string      m_password;
 	bool             m_duplex;
 	const char*      m_version;
 	bool             m_debug;
@@ -71,21 +157,21 @@ private:
 	bool             m_slot1;
 	bool             m_slot2;
 	const char*      m_hwType;
-	enum STATUS {
-		WAITING_CONNECT,
-		WAITING_LOGIN,
-		WAITING_AUTHORISATION,
-		WAITING_CONFIG,
-		WAITING_OPTIONS,
-		RUNNING
-	};
-	STATUS           m_status;
-	CTimer           m_retryTimer;
-	CTimer           m_timeoutTimer;
+	std::vector<std::pair<unsigned int, unsigned int>> m_tgRanges;
 	unsigned char*   m_buffer;
-	unsigned char*   m_salt;
+	UDPMessage*      m_rxMessages;
+	unsigned char*   m_txBuffer;
+	UDPMessage*      m_txMessages;
+	unsigned int     m_txCount;
 	uint32_t*        m_streamId;
-	CRingBuffer<unsigned char> m_rxData;
+	RX_STREAM        m_rxStream[2U];
+	CStopWatch       m_rxWatch;
+	CFrameQueue      m_rxData1;
+	CFrameQueue      m_rxData2;
+	unsigned long long m_batchTime;
+	CTimer           m_statsTimer;
+	CLatencyStats    m_rfLatency;
+	CLatencyStats    m_residency;
 	bool             m_beacon;
 	std::mt19937     m_random;
 	std::string      m_options;
@@ -102,11 +188,27 @@ private:
 	std::string      m_description;
 	std::string      m_url;
 
-	bool writeLogin();
-	bool writeAuthorisation();
-	bool writeOptions();
-	bool writeConfig();
-	bool writePing();
+	bool isRunning() const;
+	bool isHealthy(MASTER& master) const;
+
+	bool processPacket(const UDPMessage& message);
+	bool processData(unsigned int index, const UDPMessage& message);
+	void processDMRD(unsigned int index, const UDPMessage& message);
+	bool checkSeqNo(RX_STREAM& stream, uint32_t streamId, unsigned char seqNo);
+
+	static PACKET_TYPE classify(const unsigned char* buffer, unsigned int length);
+
+	void clockMaster(unsigned int index, unsigned int ms);
+	void resetMaster(unsigned int index, bool reconnect);
+	void selectActive();
+
+	void logStats() const;
+
+	bool writeLogin(MASTER& master);
+	bool writeAuthorisation(MASTER& master);
+	bool writeOptions(MASTER& master);
+	bool writeConfig(MASTER& master);
+	bool writePing(MASTER& master);
 
-	bool write(const unsigned char* data, unsigned int length);
+	bool write(MASTER& master, const unsigned char* data, unsigned int length, unsigned long long timestamp = 0ULL);
 };
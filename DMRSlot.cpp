@@ -27,6 +27,7 @@
 #include "Log.h"
 
 #include <cassert>
+#include <cstring>
 #include <ctime>
 #include <algorithm>
 #include <cstdint>
@@ -38,7 +39,7 @@ bool           CDMRSlot::m_embeddedLCOnly = false;
 bool           CDMRSlot::m_dumpTAData = true;
 
 CModem*        CDMRSlot::m_modem = NULL;
-CDMRNetwork*   CDMRSlot::m_network = NULL;
+std::vector<CDMRNetwork*> CDMRSlot::m_networks;
 CDisplay*      CDMRSlot::m_display = NULL;
 bool           CDMRSlot::m_duplex = true;
 unsigned int   CDMRSlot::m_hangCount = 3U * 17U;
@@ -65,11 +66,16 @@ const unsigned int NO_HEADERS_SIMPLEX = 8U;
 const unsigned int NO_HEADERS_DUPLEX  = 3U;
 const unsigned int NO_PREAMBLE_CSBK   = 15U;
 
+const unsigned int TIMESTAMP_LENGTH = sizeof(unsigned long long);
+
 // #define	DUMP_DMR
 
-CDMRSlot::CDMRSlot(unsigned int slotNo, unsigned int timeout) :
+CDMRSlot::CDMRSlot(unsigned int slotNo, unsigned int timeout, unsigned int jitter) :
 m_slotNo(slotNo),
-m_queue(5000U, "DMR Slot"),
+m_queue(5000U, slotNo == 1U ? "DMR Slot 1" : "DMR Slot 2", FQO_DROP_OLDEST),
+m_jitterBuffer(NULL),
+m_rfTimestamp(0ULL),
+m_netTimestamp(0ULL),
 m_rfState(RS_RF_LISTENING),
 m_netState(RS_NET_IDLE),
 m_rfEmbeddedLC(),
@@ -86,6 +92,8 @@ m_netTalkerId(TALKER_ID_NONE),
 m_netTalkerAlias(slotNo),
 m_rfLC(NULL),
 m_netLC(NULL),
+m_rfLCStorage(),
+m_netLCStorage(),
 m_rfSeqNo(0U),
 m_rfN(0U),
 m_lastrfN(0U),
@@ -107,6 +115,8 @@ m_rfTimeout(false),
 m_netTimeout(false),
 m_lastFrame(NULL),
 m_lastFrameValid(false),
+m_hangFrame(NULL),
+m_hangRemaining(0U),
 m_rssi(0U),
 m_maxRSSI(0U),
 m_minRSSI(0U),
@@ -116,10 +126,14 @@ m_enabled(true),
 m_fp(NULL)
 {
 	m_lastFrame = new unsigned char[DMR_FRAME_LENGTH_BYTES + 2U];
+	m_hangFrame = new unsigned char[DMR_FRAME_LENGTH_BYTES + 2U];
 
 	m_rfEmbeddedData  = new CDMREmbeddedData[2U];
 	m_netEmbeddedData = new CDMREmbeddedData[2U];
 
+	if (jitter > 0U)
+		m_jitterBuffer = new CDMRJitterBuffer(slotNo == 1U ? "DMR Slot 1" : "DMR Slot 2", jitter);
+
 	m_interval.start();
 }
 
@@ -128,9 +142,23 @@ CDMRSlot::~CDMRSlot()
 	delete[] m_rfEmbeddedData;
 	delete[] m_netEmbeddedData;
 	delete[] m_lastFrame;
+	delete[] m_hangFrame;
+	delete m_jitterBuffer;
 }
 
-bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
+bool CDMRSlot::writeModem(unsigned char *data, unsigned int len, unsigned long long timestamp)
+{
+	assert(data != NULL);
+
+	// Network packets sent while handling this frame carry the time it was read from the modem
+	m_rfTimestamp = timestamp;
+	bool ret = processModem(data, len);
+	m_rfTimestamp = 0ULL;
+
+	return ret;
+}
+
+bool CDMRSlot::processModem(unsigned char *data, unsigned int len)
 {
 	assert(data != NULL);
 
@@ -209,48 +237,42 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 				return true;
 
 			CDMRFullLC fullLC;
-			CDMRLC* lc = fullLC.decode(data + 2U, DT_VOICE_LC_HEADER);
-			if (lc == NULL)
+			CDMRLC lc;
+			if (!fullLC.decode(data + 2U, DT_VOICE_LC_HEADER, lc))
 				return false;
 
-			unsigned int srcId = lc->getSrcId();
-			unsigned int dstId = lc->getDstId();
-			FLCO flco = lc->getFLCO();
+			unsigned int srcId = lc.getSrcId();
+			unsigned int dstId = lc.getDstId();
+			FLCO flco = lc.getFLCO();
 
 			if (!CDMRAccessControl::validateSrcId(srcId)) {
 				LogMessage("DMR Slot %u, RF user %u rejected", m_slotNo, srcId);
-				delete lc;
 				m_rfState = RS_RF_LISTENING;
 				return false;
 			}
 
 			if (!CDMRAccessControl::validateTGId(m_slotNo, flco == FLCO_GROUP, dstId)) {
 				LogMessage("DMR Slot %u, RF user %u rejected for using TG %u", m_slotNo, srcId, dstId);
-				delete lc;
 				m_rfState = RS_RF_LISTENING;
 				return false;
 			}
 
 			if (m_ovcm == DMR_OVCM_TX_ON || m_ovcm == DMR_OVCM_ON)
-				lc->setOVCM(true);
+				lc.setOVCM(true);
 			else if (m_ovcm == DMR_OVCM_FORCE_OFF)
-				lc->setOVCM(false);
+				lc.setOVCM(false);
 
-			m_rfLC = lc;
+			m_rfLCStorage = lc;
+			m_rfLC = &m_rfLCStorage;
+			encodeLC(*m_rfLC, m_rfHeader, m_rfTerminator);
 
 			// The standby LC data
 			m_rfEmbeddedLC.setLC(*m_rfLC);
 			m_rfEmbeddedData[0U].setLC(*m_rfLC);
 			m_rfEmbeddedData[1U].setLC(*m_rfLC);
 
-			// Regenerate the LC data
-			fullLC.encode(*m_rfLC, data + 2U, DT_VOICE_LC_HEADER);
-
-			// Regenerate the Slot Type
-			slotType.getData(data + 2U);
-
-			// Convert the Data Sync to be from the BS or MS as needed
-			CSync::addDMRDataSync(data + 2U, m_duplex);
+			// Regenerate the LC data, Slot Type and Data Sync
+			::memcpy(data + 2U, m_rfHeader, DMR_FRAME_LENGTH_BYTES);
 
 			data[0U] = TAG_DATA;
 			data[1U] = 0x00U;
@@ -273,7 +295,7 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 			m_rssiCount = 1U;
 
 			if (m_duplex) {
-				m_queue.clear();
+				clearQueue();
 				m_modem->writeDMRAbort(m_slotNo);
 
 				for (unsigned int i = 0U; i < NO_HEADERS_DUPLEX; i++)
@@ -325,15 +347,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 			if (m_rfState != RS_RF_AUDIO)
 				return false;
 
-			// Regenerate the LC data
-			CDMRFullLC fullLC;
-			fullLC.encode(*m_rfLC, data + 2U, DT_TERMINATOR_WITH_LC);
-
-			// Regenerate the Slot Type
-			slotType.getData(data + 2U);
-
-			// Convert the Data Sync to be from the BS or MS as needed
-			CSync::addDMRDataSync(data + 2U, m_duplex);
+			// Regenerate the LC data, Slot Type and Data Sync
+			::memcpy(data + 2U, m_rfTerminator, DMR_FRAME_LENGTH_BYTES);
 
 			if (!m_rfTimeout) {
 				data[0U] = TAG_EOT;
@@ -341,10 +356,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 
 				writeNetworkRF(data, DT_TERMINATOR_WITH_LC);
 
-				if (m_duplex) {
-					for (unsigned int i = 0U; i < m_hangCount; i++)
-						writeQueueRF(data);
-				}
+				if (m_duplex && m_netState == RS_NET_IDLE)
+					writeHang(data, m_hangCount);
 			}
 
 			std::string src = std::to_string(m_rfLC->getSrcId());
@@ -392,7 +405,9 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 
 			m_rfFrames = dataHeader.getBlocks();
 
-			m_rfLC = new CDMRLC(gi ? FLCO_GROUP : FLCO_USER_USER, srcId, dstId);
+			// A data call has no voice header or terminator, so there is nothing to cache
+			m_rfLCStorage = CDMRLC(gi ? FLCO_GROUP : FLCO_USER_USER, srcId, dstId);
+			m_rfLC = &m_rfLCStorage;
 
 			// Regenerate the data header
 			dataHeader.get(data + 2U);
@@ -656,6 +671,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 				unsigned char _data[9U];
 				m_rfEmbeddedData[m_rfEmbeddedWriteN].getRawData(_data);
 
+				CDMRNetwork* network = findNetwork(m_rfLC->getFLCO(), m_rfLC->getDstId());
+
 				char text[80U];
 				switch (flco) {
 				case FLCO_GROUP:
@@ -670,13 +687,13 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 						CUtils::dump(1U, text, _data, 9U);
 						logGPSPosition(_data);
 					}
-					if (m_network != NULL)
-						m_network->writeRadioPosition(m_rfLC->getSrcId(), _data);
+					if (network != NULL)
+						network->writeRadioPosition(m_rfLC->getSrcId(), _data);
 					break;
 
 				case FLCO_TALKER_ALIAS_HEADER:
-					if (m_network != NULL)
-						m_network->writeTalkerAlias(m_rfLC->getSrcId(), 0U, _data);
+					if (network != NULL)
+						network->writeTalkerAlias(m_rfLC->getSrcId(), 0U, _data);
 
 					if (!(m_rfTalkerId & TALKER_ID_HEADER)) {
 						if (m_rfTalkerId == TALKER_ID_NONE)
@@ -694,8 +711,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 					break;
 
 				case FLCO_TALKER_ALIAS_BLOCK1:
-					if (m_network != NULL)
-						m_network->writeTalkerAlias(m_rfLC->getSrcId(), 1U, _data);
+					if (network != NULL)
+						network->writeTalkerAlias(m_rfLC->getSrcId(), 1U, _data);
 
 					if (!(m_rfTalkerId & TALKER_ID_BLOCK1)) {
 						if (m_rfTalkerId == TALKER_ID_NONE)
@@ -713,8 +730,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 					break;
 
 				case FLCO_TALKER_ALIAS_BLOCK2:
-					if (m_network != NULL)
-						m_network->writeTalkerAlias(m_rfLC->getSrcId(), 2U, _data);
+					if (network != NULL)
+						network->writeTalkerAlias(m_rfLC->getSrcId(), 2U, _data);
 
 					if (!(m_rfTalkerId & TALKER_ID_BLOCK2)) {
 						if (m_rfTalkerId == TALKER_ID_NONE)
@@ -732,8 +749,8 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 					break;
 
 				case FLCO_TALKER_ALIAS_BLOCK3:
-					if (m_network != NULL)
-						m_network->writeTalkerAlias(m_rfLC->getSrcId(), 3U, _data);
+					if (network != NULL)
+						network->writeTalkerAlias(m_rfLC->getSrcId(), 3U, _data);
 
 					if (!(m_rfTalkerId & TALKER_ID_BLOCK3)) {
 						if (m_rfTalkerId == TALKER_ID_NONE)
@@ -801,32 +818,32 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 				return false;
 
 			m_rfEmbeddedLC.addData(data + 2U, emb.getLCSS());
-			CDMRLC* lc = m_rfEmbeddedLC.getLC();
-			if (lc != NULL) {
-				unsigned int srcId = lc->getSrcId();
-				unsigned int dstId = lc->getDstId();
-				FLCO flco = lc->getFLCO();
+			CDMRLC lc;
+			if (m_rfEmbeddedLC.getLC(lc)) {
+				unsigned int srcId = lc.getSrcId();
+				unsigned int dstId = lc.getDstId();
+				FLCO flco = lc.getFLCO();
 
 				if (!CDMRAccessControl::validateSrcId(srcId)) {
 					LogMessage("DMR Slot %u, RF user %u rejected", m_slotNo, srcId);
-					delete lc;
 					m_rfState = RS_RF_LISTENING;
 					return false;
 				}
 
 				if (!CDMRAccessControl::validateTGId(m_slotNo, flco == FLCO_GROUP, dstId)) {
 					LogMessage("DMR Slot %u, RF user %u rejected for using TG %u", m_slotNo, srcId, dstId);
-					delete lc;
 					m_rfState = RS_RF_LISTENING;
 					return false;
 				}
 
 				if (m_ovcm == DMR_OVCM_TX_ON || m_ovcm == DMR_OVCM_ON)
-					lc->setOVCM(true);
+					lc.setOVCM(true);
 				else if (m_ovcm == DMR_OVCM_FORCE_OFF)
-					lc->setOVCM(false);
+					lc.setOVCM(false);
 
-				m_rfLC = lc;
+				m_rfLCStorage = lc;
+				m_rfLC = &m_rfLCStorage;
+				encodeLC(*m_rfLC, m_rfHeader, m_rfTerminator);
 
 				// The standby LC data
 				m_rfEmbeddedLC.setLC(*m_rfLC);
@@ -835,16 +852,7 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 
 				// Create a dummy start frame to replace the received frame
 				unsigned char start[DMR_FRAME_LENGTH_BYTES + 2U];
-
-				CSync::addDMRDataSync(start + 2U, m_duplex);
-
-				CDMRFullLC fullLC;
-				fullLC.encode(*m_rfLC, start + 2U, DT_VOICE_LC_HEADER);
-
-				CDMRSlotType slotType;
-				slotType.setColorCode(m_colorCode);
-				slotType.setDataType(DT_VOICE_LC_HEADER);
-				slotType.getData(start + 2U);
+				::memcpy(start + 2U, m_rfHeader, DMR_FRAME_LENGTH_BYTES);
 
 				start[0U] = TAG_DATA;
 				start[1U] = 0x00U;
@@ -867,7 +875,7 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 				m_rssiCount = 1U;
 
 				if (m_duplex) {
-					m_queue.clear();
+					clearQueue();
 					m_modem->writeDMRAbort(m_slotNo);
 
 					for (unsigned int i = 0U; i < NO_HEADERS_DUPLEX; i++)
@@ -928,19 +936,34 @@ bool CDMRSlot::writeModem(unsigned char *data, unsigned int len)
 	return false;
 }
 
-unsigned int CDMRSlot::readModem(unsigned char* data)
+unsigned int CDMRSlot::readModem(unsigned char* data, unsigned long long& timestamp)
 {
 	assert(data != NULL);
 
-	if (m_queue.isEmpty())
-		return 0U;
+	unsigned int length = 0U;
+	const unsigned char* frame = m_queue.peek(length);
+	if (frame == NULL) {
+		if (m_hangRemaining == 0U)
+			return 0U;
+
+		// Once the queue has drained the terminator is repeated for the rest of the hang time
+		m_hangRemaining--;
+
+		timestamp = 0ULL;
+		::memcpy(data, m_hangFrame, DMR_FRAME_LENGTH_BYTES + 2U);
+
+		return DMR_FRAME_LENGTH_BYTES + 2U;
+	}
+
+	// Each frame is the time its network packet arrived followed by the frame itself
+	::memcpy(&timestamp, frame, TIMESTAMP_LENGTH);
 
-	unsigned char len = 0U;
-	m_queue.getData(&len, 1U);
+	length -= TIMESTAMP_LENGTH;
+	::memcpy(data, frame + TIMESTAMP_LENGTH, length);
 
-	m_queue.getData(data, len);
+	m_queue.pop();
 
-	return len;
+	return length;
 }
 
 void CDMRSlot::writeEndRF(bool writeEnd)
@@ -956,22 +979,12 @@ void CDMRSlot::writeEndRF(bool writeEnd)
 		if (m_netState == RS_NET_IDLE && m_duplex && !m_rfTimeout) {
 			// Create a dummy start end frame
 			unsigned char data[DMR_FRAME_LENGTH_BYTES + 2U];
-
-			CSync::addDMRDataSync(data + 2U, m_duplex);
-
-			CDMRFullLC fullLC;
-			fullLC.encode(*m_rfLC, data + 2U, DT_TERMINATOR_WITH_LC);
-
-			CDMRSlotType slotType;
-			slotType.setColorCode(m_colorCode);
-			slotType.setDataType(DT_TERMINATOR_WITH_LC);
-			slotType.getData(data + 2U);
+			::memcpy(data + 2U, m_rfTerminator, DMR_FRAME_LENGTH_BYTES);
 
 			data[0U] = TAG_EOT;
 			data[1U] = 0x00U;
 
-			for (unsigned int i = 0U; i < m_hangCount; i++)
-				writeQueueRF(data);
+			writeHang(data, m_hangCount);
 		}
 	}
 
@@ -985,7 +998,6 @@ void CDMRSlot::writeEndRF(bool writeEnd)
 	m_rfSeqNo = 0U;
 	m_rfN = 0U;
 
-	delete m_rfLC;
 	m_rfLC = NULL;
 }
 
@@ -999,30 +1011,18 @@ void CDMRSlot::writeEndNet(bool writeEnd)
 
 	m_lastFrameValid = false;
 
+	if (m_jitterBuffer != NULL)
+		m_jitterBuffer->logStats();
+
 	if (writeEnd && !m_netTimeout) {
 		// Create a dummy start end frame
 		unsigned char data[DMR_FRAME_LENGTH_BYTES + 2U];
-
-		CSync::addDMRDataSync(data + 2U, m_duplex);
-
-		CDMRFullLC fullLC;
-		fullLC.encode(*m_netLC, data + 2U, DT_TERMINATOR_WITH_LC);
-
-		CDMRSlotType slotType;
-		slotType.setColorCode(m_colorCode);
-		slotType.setDataType(DT_TERMINATOR_WITH_LC);
-		slotType.getData(data + 2U);
+		::memcpy(data + 2U, m_netTerminator, DMR_FRAME_LENGTH_BYTES);
 
 		data[0U] = TAG_EOT;
 		data[1U] = 0x00U;
 
-		if (m_duplex) {
-			for (unsigned int i = 0U; i < m_hangCount; i++)
-				writeQueueNet(data);
-		} else {
-			for (unsigned int i = 0U; i < 3U; i++)
-				writeQueueNet(data);
-		}
+		writeHang(data, m_duplex ? m_hangCount : 3U);
 	}
 
 	m_networkWatchdog.stop();
@@ -1037,7 +1037,6 @@ void CDMRSlot::writeEndNet(bool writeEnd)
 
 	m_netN = 0U;
 
-	delete m_netLC;
 	m_netLC = NULL;
 
 #if defined(DUMP_DMR)
@@ -1050,11 +1049,43 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 	if (!m_enabled)
 		return;
 
+	if (m_jitterBuffer == NULL) {
+		processNetwork(dmrData);
+		m_netTimestamp = 0ULL;
+		return;
+	}
+
+	m_jitterBuffer->addData(dmrData);
+
+	playoutNetwork();
+}
+
+void CDMRSlot::playoutNetwork()
+{
+	assert(m_jitterBuffer != NULL);
+
+	CDMRData dmrData;
+
+	JB_STATUS status;
+	while ((status = m_jitterBuffer->getData(dmrData)) != JBS_NO_DATA) {
+		if (status == JBS_DATA) {
+			processNetwork(dmrData);
+			m_netTimestamp = 0ULL;
+		} else if (m_netState == RS_NET_AUDIO)
+			insertSilence(1U);
+	}
+}
+
+void CDMRSlot::processNetwork(const CDMRData& dmrData)
+{
 	if (m_rfState != RS_RF_LISTENING && m_netState == RS_NET_IDLE)
 		return;
 
 	m_networkWatchdog.start();
 
+	// Frames queued while handling this packet carry its arrival time, generated ones carry none
+	m_netTimestamp = dmrData.getTimestamp();
+
 	unsigned char dataType = dmrData.getDataType();
 
 	unsigned char data[DMR_FRAME_LENGTH_BYTES + 2U];
@@ -1065,15 +1096,15 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 			return;
 
 		CDMRFullLC fullLC;
-		CDMRLC* lc = fullLC.decode(data + 2U, DT_VOICE_LC_HEADER);
-		if (lc == NULL) {
+		CDMRLC lc;
+		if (!fullLC.decode(data + 2U, DT_VOICE_LC_HEADER, lc)) {
 			LogMessage("DMR Slot %u, bad LC received from the network, replacing", m_slotNo);
-			lc = new CDMRLC(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
+			lc = CDMRLC(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
 		}
 
-		unsigned int dstId = lc->getDstId();
-		unsigned int srcId = lc->getSrcId();
-		FLCO flco          = lc->getFLCO();
+		unsigned int dstId = lc.getDstId();
+		unsigned int srcId = lc.getSrcId();
+		FLCO flco          = lc.getFLCO();
 
 		if (dstId != dmrData.getDstId() || srcId != dmrData.getSrcId() || flco != dmrData.getFLCO())
 			LogWarning("DMR Slot %u, DMRD header doesn't match the DMR RF header: %u->%s%u %u->%s%u", m_slotNo,
@@ -1081,28 +1112,21 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 				srcId, flco == FLCO_GROUP ? "TG" : "", dstId);
 
 		if (m_ovcm == DMR_OVCM_RX_ON || m_ovcm == DMR_OVCM_ON)
-			lc->setOVCM(true);
+			lc.setOVCM(true);
 		else if (m_ovcm == DMR_OVCM_FORCE_OFF)
-			lc->setOVCM(false);
+			lc.setOVCM(false);
 
-		m_netLC = lc;
+		m_netLCStorage = lc;
+		m_netLC = &m_netLCStorage;
+		encodeLC(*m_netLC, m_netHeader, m_netTerminator);
 
 		// The standby LC data
 		m_netEmbeddedLC.setLC(*m_netLC);
 		m_netEmbeddedData[0U].setLC(*m_netLC);
 		m_netEmbeddedData[1U].setLC(*m_netLC);
 
-		// Regenerate the LC data
-		fullLC.encode(*m_netLC, data + 2U, DT_VOICE_LC_HEADER);
-
-		// Regenerate the Slot Type
-		CDMRSlotType slotType;
-		slotType.setColorCode(m_colorCode);
-		slotType.setDataType(DT_VOICE_LC_HEADER);
-		slotType.getData(data + 2U);
-
-		// Convert the Data Sync to be from the BS or MS as needed
-		CSync::addDMRDataSync(data + 2U, m_duplex);
+		// Regenerate the LC data, Slot Type and Data Sync
+		::memcpy(data + 2U, m_netHeader, DMR_FRAME_LENGTH_BYTES);
 
 		data[0U] = TAG_DATA;
 		data[1U] = 0x00U;
@@ -1122,7 +1146,7 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 		m_netTalkerId       = TALKER_ID_NONE;
 
 		if (m_duplex) {
-			m_queue.clear();
+			clearQueue();
 			m_modem->writeDMRAbort(m_slotNo);
 		}
 
@@ -1150,17 +1174,19 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 		LogMessage("DMR Slot %u, received network voice header from %s to %s%s", m_slotNo, src.c_str(), flco == FLCO_GROUP ? "TG " : "", dst.c_str());
 	} else if (dataType == DT_VOICE_PI_HEADER) {
 		if (m_netState != RS_NET_AUDIO) {
-			CDMRLC* lc = new CDMRLC(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
+			CDMRLC lc(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
 
-			unsigned int dstId = lc->getDstId();
-			unsigned int srcId = lc->getSrcId();
+			unsigned int dstId = lc.getDstId();
+			unsigned int srcId = lc.getSrcId();
 
 			if (m_ovcm == DMR_OVCM_RX_ON || m_ovcm == DMR_OVCM_ON)
-				lc->setOVCM(true);
+				lc.setOVCM(true);
 			else if (m_ovcm == DMR_OVCM_FORCE_OFF)
-				lc->setOVCM(false);
+				lc.setOVCM(false);
 
-			m_netLC = lc;
+			m_netLCStorage = lc;
+			m_netLC = &m_netLCStorage;
+			encodeLC(*m_netLC, m_netHeader, m_netTerminator);
 
 			m_lastFrameValid = false;
 
@@ -1168,22 +1194,13 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 			m_netTimeout = false;
 
 			if (m_duplex) {
-				m_queue.clear();
+				clearQueue();
 				m_modem->writeDMRAbort(m_slotNo);
 			}
 
 			// Create a dummy start frame
 			unsigned char start[DMR_FRAME_LENGTH_BYTES + 2U];
-
-			CSync::addDMRDataSync(start + 2U, m_duplex);
-
-			CDMRFullLC fullLC;
-			fullLC.encode(*m_netLC, start + 2U, DT_VOICE_LC_HEADER);
-
-			CDMRSlotType slotType;
-			slotType.setColorCode(m_colorCode);
-			slotType.setDataType(DT_VOICE_LC_HEADER);
-			slotType.getData(start + 2U);
+			::memcpy(start + 2U, m_netHeader, DMR_FRAME_LENGTH_BYTES);
 
 			start[0U] = TAG_DATA;
 			start[1U] = 0x00U;
@@ -1242,30 +1259,14 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 		if (m_netState != RS_NET_AUDIO)
 			return;
 
-		// Regenerate the LC data
-		CDMRFullLC fullLC;
-		fullLC.encode(*m_netLC, data + 2U, DT_TERMINATOR_WITH_LC);
-
-		// Regenerate the Slot Type
-		CDMRSlotType slotType;
-		slotType.setColorCode(m_colorCode);
-		slotType.setDataType(DT_TERMINATOR_WITH_LC);
-		slotType.getData(data + 2U);
-
-		// Convert the Data Sync to be from the BS or MS as needed
-		CSync::addDMRDataSync(data + 2U, m_duplex);
+		// Regenerate the LC data, Slot Type and Data Sync
+		::memcpy(data + 2U, m_netTerminator, DMR_FRAME_LENGTH_BYTES);
 
 		if (!m_netTimeout) {
 			data[0U] = TAG_EOT;
 			data[1U] = 0x00U;
 
-			if (m_duplex) {
-				for (unsigned int i = 0U; i < m_hangCount; i++)
-					writeQueueNet(data);
-			} else {
-				for (unsigned int i = 0U; i < 3U; i++)
-					writeQueueNet(data);
-			}
+			writeHang(data, m_duplex ? m_hangCount : 3U);
 		}
 
 #if defined(DUMP_DMR)
@@ -1336,17 +1337,19 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 		}
 	} else if (dataType == DT_VOICE_SYNC) {
 		if (m_netState == RS_NET_IDLE) {
-			CDMRLC* lc = new CDMRLC(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
+			CDMRLC lc(dmrData.getFLCO(), dmrData.getSrcId(), dmrData.getDstId());
 
-			unsigned int dstId = lc->getDstId();
-			unsigned int srcId = lc->getSrcId();
+			unsigned int dstId = lc.getDstId();
+			unsigned int srcId = lc.getSrcId();
 
 			if (m_ovcm == DMR_OVCM_RX_ON || m_ovcm == DMR_OVCM_ON)
-				lc->setOVCM(true);
+				lc.setOVCM(true);
 			else if (m_ovcm == DMR_OVCM_FORCE_OFF)
-				lc->setOVCM(false);
+				lc.setOVCM(false);
 
-			m_netLC = lc;
+			m_netLCStorage = lc;
+			m_netLC = &m_netLCStorage;
+			encodeLC(*m_netLC, m_netHeader, m_netTerminator);
 
 			// The standby LC data
 			m_netEmbeddedLC.setLC(*m_netLC);
@@ -1359,22 +1362,13 @@ void CDMRSlot::writeNetwork(const CDMRData& dmrData)
 			m_netTimeout = false;
 
 			if (m_duplex) {
-				m_queue.clear();
+				clearQueue();
 				m_modem->writeDMRAbort(m_slotNo);
 			}
 
 			// Create a dummy start frame
 			unsigned char start[DMR_FRAME_LENGTH_BYTES + 2U];
-
-			CSync::addDMRDataSync(start + 2U, m_duplex);
-
-			CDMRFullLC fullLC;
-			fullLC.encode(*m_netLC, start + 2U, DT_VOICE_LC_HEADER);
-
-			CDMRSlotType slotType;
-			slotType.setColorCode(m_colorCode);
-			slotType.setDataType(DT_VOICE_LC_HEADER);
-			slotType.getData(start + 2U);
+			::memcpy(start + 2U, m_netHeader, DMR_FRAME_LENGTH_BYTES);
 
 			start[0U] = TAG_DATA;
 			start[1U] = 0x00U;
@@ -1810,6 +1804,9 @@ void CDMRSlot::clock()
 	unsigned int ms = m_interval.elapsed();
 	m_interval.start();
 
+	if (m_jitterBuffer != NULL)
+		playoutNetwork();
+
 	m_rfTimeoutTimer.clock(ms);
 	if (m_rfTimeoutTimer.isRunning() && m_rfTimeoutTimer.hasExpired()) {
 		if (!m_rfTimeout) {
@@ -1856,16 +1853,7 @@ void CDMRSlot::writeQueueRF(const unsigned char *data)
 	if (m_netState != RS_NET_IDLE)
 		return;
 
-	unsigned char len = DMR_FRAME_LENGTH_BYTES + 2U;
-
-	unsigned int space = m_queue.freeSpace();
-	if (space < (len + 1U)) {
-		LogError("DMR Slot %u, overflow in the DMR slot RF queue", m_slotNo);
-		return;
-	}
-
-	m_queue.addData(&len, 1U);
-	m_queue.addData(data, len);
+	writeQueue(data, 0ULL);
 }
 
 void CDMRSlot::writeNetworkRF(const unsigned char* data, unsigned char dataType, FLCO flco, unsigned int srcId, unsigned int dstId, unsigned char errors)
@@ -1875,7 +1863,8 @@ void CDMRSlot::writeNetworkRF(const unsigned char* data, unsigned char dataType,
 	if (m_netState != RS_NET_IDLE)
 		return;
 
-	if (m_network == NULL)
+	CDMRNetwork* network = findNetwork(flco, dstId);
+	if (network == NULL)
 		return;
 
 	CDMRData dmrData;
@@ -1892,8 +1881,9 @@ void CDMRSlot::writeNetworkRF(const unsigned char* data, unsigned char dataType,
 	m_rfSeqNo++;
 
 	dmrData.setData(data + 2U);
+	dmrData.setTimestamp(m_rfTimestamp);
 
-	m_network->write(dmrData);
+	network->write(dmrData);
 }
 
 void CDMRSlot::writeNetworkRF(const unsigned char* data, unsigned char dataType, unsigned char errors)
@@ -1904,23 +1894,76 @@ void CDMRSlot::writeNetworkRF(const unsigned char* data, unsigned char dataType,
 	writeNetworkRF(data, dataType, m_rfLC->getFLCO(), m_rfLC->getSrcId(), m_rfLC->getDstId(), errors);
 }
 
+CDMRNetwork* CDMRSlot::findNetwork(FLCO flco, unsigned int dstId) const
+{
+	// The first session configured for this slot and destination carries the traffic
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_networks.begin(); it != m_networks.end(); ++it) {
+		if ((*it)->routes(m_slotNo, flco, dstId))
+			return *it;
+	}
+
+	return NULL;
+}
+
 void CDMRSlot::writeQueueNet(const unsigned char *data)
 {
 	assert(data != NULL);
 
-	unsigned char len = DMR_FRAME_LENGTH_BYTES + 2U;
+	writeQueue(data, m_netTimestamp);
+}
 
-	unsigned int space = m_queue.freeSpace();
-	if (space < (len + 1U)) {
-		LogError("DMR Slot %u, overflow in the DMR slot RF queue", m_slotNo);
+void CDMRSlot::writeQueue(const unsigned char* data, unsigned long long timestamp)
+{
+	// Anything new for the air cuts the hang time short
+	m_hangRemaining = 0U;
+
+	// A full queue loses its oldest frame rather than this one
+	unsigned char* frame = m_queue.reserve(TIMESTAMP_LENGTH + DMR_FRAME_LENGTH_BYTES + 2U);
+	if (frame == NULL)
 		return;
-	}
 
-	m_queue.addData(&len, 1U);
-	m_queue.addData(data, len);
+	::memcpy(frame, &timestamp, TIMESTAMP_LENGTH);
+	::memcpy(frame + TIMESTAMP_LENGTH, data, DMR_FRAME_LENGTH_BYTES + 2U);
+
+	m_queue.commit(TIMESTAMP_LENGTH + DMR_FRAME_LENGTH_BYTES + 2U);
 }
 
-void CDMRSlot::init(unsigned int colorCode, bool embeddedLCOnly, bool dumpTAData, unsigned int callHang, CModem* modem, CDMRNetwork* network, CDisplay* display, bool duplex, CRSSIInterpolator* rssiMapper, DMR_OVCM_TYPES ovcm)
+void CDMRSlot::writeHang(const unsigned char* data, unsigned int count)
+{
+	assert(data != NULL);
+
+	::memcpy(m_hangFrame, data, DMR_FRAME_LENGTH_BYTES + 2U);
+	m_hangRemaining = count;
+}
+
+void CDMRSlot::clearQueue()
+{
+	m_queue.clear();
+	m_hangRemaining = 0U;
+}
+
+void CDMRSlot::encodeLC(const CDMRLC& lc, unsigned char* header, unsigned char* terminator)
+{
+	assert(header != NULL);
+	assert(terminator != NULL);
+
+	// The LC, colour code and sync don't change during a call, so the header and terminator are only built once
+	CDMRFullLC fullLC;
+	CDMRSlotType slotType;
+	slotType.setColorCode(m_colorCode);
+
+	fullLC.encode(lc, header, DT_VOICE_LC_HEADER);
+	slotType.setDataType(DT_VOICE_LC_HEADER);
+	slotType.getData(header);
+	CSync::addDMRDataSync(header, m_duplex);
+
+	fullLC.encode(lc, terminator, DT_TERMINATOR_WITH_LC);
+	slotType.setDataType(DT_TERMINATOR_WITH_LC);
+	slotType.getData(terminator);
+	CSync::addDMRDataSync(terminator, m_duplex);
+}
+
+void CDMRSlot::init(unsigned int colorCode, bool embeddedLCOnly, bool dumpTAData, unsigned int callHang, CModem* modem, const std::vector<CDMRNetwork*>& networks, CDisplay* display, bool duplex, CRSSIInterpolator* rssiMapper, DMR_OVCM_TYPES ovcm)
 {
 	assert(modem != NULL);
 	assert(display != NULL);
@@ -1930,7 +1973,7 @@ void CDMRSlot::init(unsigned int colorCode, bool embeddedLCOnly, bool dumpTAData
 	m_embeddedLCOnly = embeddedLCOnly;
 	m_dumpTAData     = dumpTAData;
 	m_modem          = modem;
-	m_network        = network;
+	m_networks       = networks;
 	m_display        = display;
 	m_duplex         = duplex;
 	m_hangCount      = callHang * 17U;
@@ -2160,6 +2203,14 @@ void CDMRSlot::insertSilence(unsigned int count)
 	}
 }
 
+unsigned int CDMRSlot::getTimeout()
+{
+	if (m_jitterBuffer == NULL)
+		return 0xFFFFFFFFU;
+
+	return m_jitterBuffer->getTimeout();
+}
+
 bool CDMRSlot::isBusy() const
 {
 	return m_rfState != RS_RF_LISTENING || m_netState != RS_NET_IDLE;
@@ -2168,7 +2219,10 @@ bool CDMRSlot::isBusy() const
 void CDMRSlot::enable(bool enabled)
 {
 	if (!enabled && m_enabled) {
-		m_queue.clear();
+		clearQueue();
+
+		if (m_jitterBuffer != NULL)
+			m_jitterBuffer->reset();
 
 		// Reset the RF section
 		m_rfState = RS_RF_LISTENING;
@@ -2183,7 +2237,6 @@ void CDMRSlot::enable(bool enabled)
 		m_rfSeqNo = 0U;
 		m_rfN = 0U;
 
-		delete m_rfLC;
 		m_rfLC = NULL;
 
 		// Reset the networking section
@@ -2203,7 +2256,6 @@ void CDMRSlot::enable(bool enabled)
 
 		m_netN = 0U;
 
-		delete m_netLC;
 		m_netLC = NULL;
 	}
 
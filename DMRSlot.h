@@ -20,9 +20,10 @@
 
 #include "RSSIInterpolator.h"
 #include "DMREmbeddedData.h"
+#include "DMRJitterBuffer.h"
 #include "DMRNetwork.h"
 #include "DMRTA.h"
-#include "RingBuffer.h"
+#include "FrameQueue.h"
 #include "StopWatch.h"
 #include "AMBEFEC.h"
 #include "DMRSlot.h"
@@ -45,26 +46,31 @@ enum ACTIVITY_TYPE {
 
 class CDMRSlot {
 public:
-	CDMRSlot(unsigned int slotNo, unsigned int timeout);
+	CDMRSlot(unsigned int slotNo, unsigned int timeout, unsigned int jitter);
 	~CDMRSlot();
 
-	bool writeModem(unsigned char* data, unsigned int len);
+	bool writeModem(unsigned char* data, unsigned int len, unsigned long long timestamp);
 
-	unsigned int readModem(unsigned char* data);
+	unsigned int readModem(unsigned char* data, unsigned long long& timestamp);
 
 	void writeNetwork(const CDMRData& data);
 
 	void clock();
 
+	unsigned int getTimeout();
+
 	bool isBusy() const;
 
 	void enable(bool enabled);
 
-	static void init(unsigned int colorCode, bool embeddedLCOnly, bool dumpTAData, unsigned int callHang, CModem* modem, CDMRNetwork* network, CDisplay* display, bool duplex, CRSSIInterpolator* rssiMapper, DMR_OVCM_TYPES ovcm);
+	static void init(unsigned int colorCode, bool embeddedLCOnly, bool dumpTAData, unsigned int callHang, CModem* modem, const std::vector<CDMRNetwork*>& networks, CDisplay* display, bool duplex, CRSSIInterpolator* rssiMapper, DMR_OVCM_TYPES ovcm);
 
 private:
 	unsigned int               m_slotNo;
-	CRingBuffer<unsigned char> m_queue;
+	CFrameQueue                m_queue;
+	CDMRJitterBuffer*          m_jitterBuffer;
+	unsigned long long         m_rfTimestamp;
+	unsigned long long         m_netTimestamp;
 	RPT_RF_STATE               m_rfState;
 	RPT_NET_STATE              m_netState;
 	CDMREmbeddedData           m_rfEmbeddedLC;
@@ -79,8 +85,15 @@ private:
 	unsigned int               m_netEmbeddedWriteN;
 	unsigned char              m_netTalkerId;
 	CDMRTA                     m_netTalkerAlias;
+	// Point at the storage below while a call is up, so call setup never touches the heap
 	CDMRLC*                    m_rfLC;
 	CDMRLC*                    m_netLC;
+	CDMRLC                     m_rfLCStorage;
+	CDMRLC                     m_netLCStorage;
+	unsigned char              m_rfHeader[DMR_FRAME_LENGTH_BYTES];
+	unsigned char              m_rfTerminator[DMR_FRAME_LENGTH_BYTES];
+	unsigned char              m_netHeader[DMR_FRAME_LENGTH_BYTES];
+	unsigned char              m_netTerminator[DMR_FRAME_LENGTH_BYTES];
 	unsigned char              m_rfSeqNo;
 	unsigned char              m_rfN;
 	unsigned char              m_lastrfN;
@@ -102,6 +115,8 @@ private:
 	bool                       m_netTimeout;
 	unsigned char*             m_lastFrame;
 	bool                       m_lastFrameValid;
+	unsigned char*             m_hangFrame;
+	unsigned int               m_hangRemaining;
 	unsigned char              m_rssi;
 	unsigned char              m_maxRSSI;
 	unsigned char              m_minRSSI;
@@ -116,7 +131,7 @@ private:
 	static bool                m_dumpTAData;
 
 	static CModem*             m_modem;
-	static CDMRNetwork*        m_network;
+	static std::vector<CDMRNetwork*> m_networks;
 	static CDisplay*           m_display;
 	static bool                m_duplex;
 	static unsigned int        m_hangCount;
@@ -135,8 +150,19 @@ private:
 
 	void logGPSPosition(const unsigned char* data);
 
+	CDMRNetwork* findNetwork(FLCO flco, unsigned int dstId) const;
+
+	bool processModem(unsigned char* data, unsigned int len);
+
+	void processNetwork(const CDMRData& data);
+	void playoutNetwork();
+
 	void writeQueueRF(const unsigned char* data);
 	void writeQueueNet(const unsigned char* data);
+	void writeQueue(const unsigned char* data, unsigned long long timestamp);
+	void writeHang(const unsigned char* data, unsigned int count);
+	void clearQueue();
+	void encodeLC(const CDMRLC& lc, unsigned char* header, unsigned char* terminator);
 	void writeNetworkRF(const unsigned char* data, unsigned char dataType, unsigned char errors = 0U);
 	void writeNetworkRF(const unsigned char* data, unsigned char dataType, FLCO flco, unsigned int srcId, unsigned int dstId, unsigned char errors = 0U);
 
@@ -0,0 +1,192 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "DNSResolver.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+// How long to wait before trying again after a failed lookup, never longer than a normal refresh
+const unsigned int DNS_RETRY_SECS = 30U;
+
+std::map<std::string, CDNSResolver::ENTRY> CDNSResolver::m_entries;
+std::mutex                                 CDNSResolver::m_mutex;
+std::condition_variable                    CDNSResolver::m_cond;
+std::thread                                CDNSResolver::m_thread;
+bool                                       CDNSResolver::m_running = false;
+unsigned int                               CDNSResolver::m_refresh = 300U;
+
+bool CDNSResolver::start(unsigned int refresh)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_running)
+		return true;
+
+	m_refresh = refresh;
+	m_running = true;
+	m_thread  = std::thread(&CDNSResolver::threadMain);
+
+	LogMessage("Started the DNS resolver thread");
+
+	return true;
+}
+
+void CDNSResolver::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_running)
+			return;
+
+		m_running = false;
+	}
+
+	m_cond.notify_one();
+
+	// A lookup already in progress has to run its course
+	m_thread.join();
+
+	LogMessage("Stopped the DNS resolver thread");
+}
+
+bool CDNSResolver::lookup(const std::string& hostName, unsigned short port, sockaddr_storage& address, unsigned int& addressLength)
+{
+	// Numeric addresses never touch the resolver
+	sockaddr_storage numeric;
+	::memset(&numeric, 0x00U, sizeof(sockaddr_storage));
+
+	sockaddr_in* in = (sockaddr_in*)&numeric;
+	sockaddr_in6* in6 = (sockaddr_in6*)&numeric;
+	if (::inet_pton(AF_INET, hostName.c_str(), &in->sin_addr) == 1) {
+		in->sin_family = AF_INET;
+		in->sin_port   = htons(port);
+		address        = numeric;
+		addressLength  = sizeof(sockaddr_in);
+		return true;
+	}
+	if (::inet_pton(AF_INET6, hostName.c_str(), &in6->sin6_addr) == 1) {
+		in6->sin6_family = AF_INET6;
+		in6->sin6_port   = htons(port);
+		address          = numeric;
+		addressLength    = sizeof(sockaddr_in6);
+		return true;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (!m_running) {
+		lock.unlock();
+		return CUDPSocket::lookup(hostName, port, address, addressLength) == 0;
+	}
+
+	std::string key = hostName + ":" + std::to_string(port);
+
+	std::map<std::string, ENTRY>::iterator it = m_entries.find(key);
+	if (it == m_entries.end()) {
+		ENTRY entry;
+		entry.m_hostName      = hostName;
+		entry.m_port          = port;
+		entry.m_addressLength = 0U;
+		entry.m_valid         = false;
+		entry.m_due           = std::chrono::steady_clock::now();
+		m_entries[key] = entry;
+
+		lock.unlock();
+		m_cond.notify_one();
+		return false;
+	}
+
+	if (!it->second.m_valid)
+		return false;
+
+	::memcpy(&address, &it->second.m_address, it->second.m_addressLength);
+	addressLength = it->second.m_addressLength;
+
+	return true;
+}
+
+void CDNSResolver::refresh(const std::string& hostName, unsigned short port)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	std::map<std::string, ENTRY>::iterator it = m_entries.find(hostName + ":" + std::to_string(port));
+	if (it == m_entries.end())
+		return;
+
+	it->second.m_due = std::chrono::steady_clock::now();
+
+	lock.unlock();
+	m_cond.notify_one();
+}
+
+void CDNSResolver::threadMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (m_running) {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point next = now + std::chrono::seconds(m_refresh);
+
+		ENTRY* due = NULL;
+		for (std::map<std::string, ENTRY>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+			if (it->second.m_due <= now) {
+				due = &it->second;
+				break;
+			}
+
+			if (it->second.m_due < next)
+				next = it->second.m_due;
+		}
+
+		if (due == NULL) {
+			m_cond.wait_until(lock, next);
+			continue;
+		}
+
+		std::string hostName = due->m_hostName;
+		unsigned short port  = due->m_port;
+
+		// getaddrinfo() may take seconds, the cache stays usable meanwhile
+		lock.unlock();
+
+		sockaddr_storage address;
+		unsigned int addressLength = 0U;
+		int err = CUDPSocket::lookup(hostName, port, address, addressLength);
+
+		lock.lock();
+
+		// Entries are never removed so the pointer is still good
+		if (err == 0) {
+			if (!due->m_valid || !CUDPSocket::match(due->m_address, address))
+				LogMessage("Resolved %s", hostName.c_str());
+
+			::memcpy(&due->m_address, &address, addressLength);
+			due->m_addressLength = addressLength;
+			due->m_valid         = true;
+			due->m_due           = std::chrono::steady_clock::now() + std::chrono::seconds(m_refresh);
+		} else {
+			if (due->m_valid)
+				LogWarning("Cannot refresh the address of %s, keeping the last one", hostName.c_str());
+
+			due->m_due = std::chrono::steady_clock::now() + std::chrono::seconds(std::min(DNS_RETRY_SECS, m_refresh));
+		}
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#pragma once
+
+#include "UDPSocket.h"
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+// Resolves host names on a thread of its own so that a slow resolver never holds up the main loop.
+// Results are cached and refreshed in the background, a failed refresh keeps the last good address.
+class CDNSResolver {
+public:
+	static bool start(unsigned int refresh);
+	static void stop();
+
+	// Never blocks while the resolver is running, returns false until the name has been resolved once
+	static bool lookup(const std::string& hostName, unsigned short port, sockaddr_storage& address, unsigned int& addressLength);
+
+	// Resolve the name again soon, e.g. after the connection to it has failed
+	static void refresh(const std::string& hostName, unsigned short port);
+
+private:
+	struct ENTRY {
+		std::string      m_hostName;
+		unsigned short   m_port;
+		sockaddr_storage m_address;
+		unsigned int     m_addressLength;
+		bool             m_valid;
+		std::chrono::steady_clock::time_point m_due;
+	};
+
+	static std::map<std::string, ENTRY> m_entries;
+	static std::mutex                   m_mutex;
+	static std::condition_variable      m_cond;
+	static std::thread                  m_thread;
+	static bool                         m_running;
+	static unsigned int                 m_refresh;
+
+	static void threadMain();
+};
@@ -0,0 +1,66 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "EventLoop.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cerrno>
+
+CEventLoop::CEventLoop() :
+m_fds(),
+m_count(0U)
+{
+}
+
+CEventLoop::~CEventLoop()
+{
+}
+
+void CEventLoop::clear()
+{
+	m_count = 0U;
+}
+
+void CEventLoop::add(int fd)
+{
+	// Closed or not yet opened sockets are simply skipped
+	if (fd < 0)
+		return;
+
+	assert(m_count < EVENT_LOOP_MAX_FDS);
+
+	m_fds[m_count].fd      = fd;
+	m_fds[m_count].events  = POLLIN;
+	m_fds[m_count].revents = 0;
+	m_count++;
+}
+
+int CEventLoop::wait(unsigned int ms)
+{
+	int ret = ::poll(m_fds, m_count, int(ms));
+	if (ret < 0) {
+		if (errno == EINTR)
+			return 0;
+
+		LogError("Error returned from poll(), errno=%d", errno);
+		return -1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,40 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#pragma once
+
+#include <poll.h>
+
+const unsigned int EVENT_LOOP_MAX_FDS = 8U;
+
+class CEventLoop {
+public:
+	CEventLoop();
+	~CEventLoop();
+
+	void clear();
+
+	void add(int fd);
+
+	// Block until one of the descriptors is readable or the timeout in ms expires
+	int  wait(unsigned int ms);
+
+private:
+	pollfd       m_fds[EVENT_LOOP_MAX_FDS];
+	unsigned int m_count;
+};
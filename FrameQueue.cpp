@@ -0,0 +1,322 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FrameQueue.h"
+#include "Log.h"
+
+#include <cassert>
+#include <cstring>
+
+// Each frame is preceded by its length in two bytes, this length marks the rest of the buffer as unused
+const unsigned int HEADER_LENGTH = 2U;
+const unsigned int WRAP_MARKER   = 0xFFFFU;
+
+// Overflows come in bursts, after logging one the rest are only counted for this long, in ms
+const unsigned int OVERFLOW_REPORT_INTERVAL = 1000U;
+
+CFrameQueue::CFrameQueue(unsigned int length, const char* name, FRAME_QUEUE_OVERFLOW overflow) :
+m_length(1U),
+m_mask(0U),
+m_name(name),
+m_overflow(overflow),
+m_buffer(NULL),
+m_reserved(0U),
+m_skip(0U),
+m_watch(),
+m_lastReport(0ULL),
+m_dropped(0U),
+m_highWater(0U),
+m_pad1(),
+m_iPtr(0U),
+m_pad2(),
+m_oPtr(0U),
+m_pad3()
+{
+	assert(length > 0U);
+	assert(name != NULL);
+
+	while (m_length < length)
+		m_length <<= 1;
+	m_mask = m_length - 1U;
+
+	m_buffer = new unsigned char[m_length];
+
+	::memset(m_buffer, 0x00U, m_length);
+}
+
+CFrameQueue::~CFrameQueue()
+{
+	delete[] m_buffer;
+}
+
+void CFrameQueue::setOverflow(FRAME_QUEUE_OVERFLOW overflow)
+{
+	m_overflow = overflow;
+}
+
+unsigned char* CFrameQueue::reserve(unsigned int length)
+{
+	if (length >= WRAP_MARKER || (length + HEADER_LENGTH) > (m_length / 2U)) {
+		LogError("%s frame is too long, dropping it. (%u)", m_name, length);
+		m_dropped.fetch_add(1U, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	unsigned int iPtr = m_iPtr.load(std::memory_order_relaxed);
+	unsigned int oPtr = m_oPtr.load(std::memory_order_acquire);
+
+	// A frame that would straddle the end of the buffer starts again at the beginning
+	unsigned int skip  = skipFor(iPtr, length);
+	unsigned int space = m_length - (iPtr - oPtr);
+
+	while ((skip + HEADER_LENGTH + length) > space) {
+		switch (m_overflow) {
+		case FQO_DROP_OLDEST:
+			pop();
+			m_dropped.fetch_add(1U, std::memory_order_relaxed);
+			if (reportOverflow())
+				LogWarning("%s buffer overflow, dropping the oldest frame, %u frames dropped so far", m_name, getDropped());
+			break;
+		case FQO_CLEAR:
+			m_dropped.fetch_add(countFrames(), std::memory_order_relaxed);
+			clear();
+			if (reportOverflow())
+				LogError("%s buffer overflow, clearing the buffer, %u frames dropped so far", m_name, getDropped());
+			break;
+		default:
+			m_dropped.fetch_add(1U, std::memory_order_relaxed);
+			if (reportOverflow())
+				LogError("%s buffer overflow, dropping the frame. (%u > %u), %u frames dropped so far", m_name, skip + HEADER_LENGTH + length, space, getDropped());
+			return NULL;
+		}
+
+		oPtr  = m_oPtr.load(std::memory_order_acquire);
+		space = m_length - (iPtr - oPtr);
+	}
+
+	unsigned int ptr = iPtr & m_mask;
+	if (skip >= HEADER_LENGTH) {
+		m_buffer[ptr + 0U] = WRAP_MARKER & 0xFFU;
+		m_buffer[ptr + 1U] = (WRAP_MARKER >> 8) & 0xFFU;
+	}
+
+	m_reserved = length;
+	m_skip     = skip;
+
+	return m_buffer + ((iPtr + skip) & m_mask) + HEADER_LENGTH;
+}
+
+void CFrameQueue::commit(unsigned int length)
+{
+	assert(length <= m_reserved);
+
+	unsigned int iPtr = m_iPtr.load(std::memory_order_relaxed) + m_skip;
+
+	unsigned int ptr = iPtr & m_mask;
+	m_buffer[ptr + 0U] = length & 0xFFU;
+	m_buffer[ptr + 1U] = (length >> 8) & 0xFFU;
+
+	m_reserved = 0U;
+	m_skip     = 0U;
+
+	iPtr += HEADER_LENGTH + length;
+
+	m_iPtr.store(iPtr, std::memory_order_release);
+
+	unsigned int size = iPtr - m_oPtr.load(std::memory_order_acquire);
+	if (size > m_highWater.load(std::memory_order_relaxed))
+		m_highWater.store(size, std::memory_order_relaxed);
+}
+
+bool CFrameQueue::addData(const unsigned char* data, unsigned int length)
+{
+	assert(data != NULL);
+
+	unsigned char* buffer = reserve(length);
+	if (buffer == NULL)
+		return false;
+
+	::memcpy(buffer, data, length);
+
+	commit(length);
+
+	return true;
+}
+
+const unsigned char* CFrameQueue::peek(unsigned int& length) const
+{
+	unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+	unsigned int iPtr = m_iPtr.load(std::memory_order_acquire);
+
+	if (oPtr == iPtr) {
+		length = 0U;
+		return NULL;
+	}
+
+	unsigned int ptr = frameStart(oPtr) & m_mask;
+
+	length = m_buffer[ptr + 0U] | (m_buffer[ptr + 1U] << 8);
+
+	return m_buffer + ptr + HEADER_LENGTH;
+}
+
+void CFrameQueue::pop()
+{
+	unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+	unsigned int iPtr = m_iPtr.load(std::memory_order_acquire);
+
+	if (oPtr == iPtr)
+		return;
+
+	oPtr = frameStart(oPtr);
+
+	unsigned int ptr    = oPtr & m_mask;
+	unsigned int length = m_buffer[ptr + 0U] | (m_buffer[ptr + 1U] << 8);
+
+	m_oPtr.store(oPtr + HEADER_LENGTH + length, std::memory_order_release);
+}
+
+unsigned int CFrameQueue::getData(unsigned char* data)
+{
+	assert(data != NULL);
+
+	unsigned int length = 0U;
+	const unsigned char* buffer = peek(length);
+	if (buffer == NULL)
+		return 0U;
+
+	::memcpy(data, buffer, length);
+
+	pop();
+
+	return length;
+}
+
+void CFrameQueue::clear()
+{
+	m_oPtr.store(m_iPtr.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+unsigned int CFrameQueue::getMark() const
+{
+	return m_iPtr.load(std::memory_order_relaxed);
+}
+
+void CFrameQueue::clearTo(unsigned int mark)
+{
+	// The consumer may already have read past the mark, and the frames after it are kept
+	unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+	if (int(mark - oPtr) > 0)
+		m_oPtr.store(mark, std::memory_order_release);
+}
+
+unsigned int CFrameQueue::freeSpace() const
+{
+	return m_length - dataSize();
+}
+
+unsigned int CFrameQueue::dataSize() const
+{
+	return m_iPtr.load(std::memory_order_acquire) - m_oPtr.load(std::memory_order_acquire);
+}
+
+bool CFrameQueue::hasSpace(unsigned int length) const
+{
+	unsigned int iPtr = m_iPtr.load(std::memory_order_relaxed);
+	unsigned int oPtr = m_oPtr.load(std::memory_order_acquire);
+
+	return (skipFor(iPtr, length) + HEADER_LENGTH + length) <= (m_length - (iPtr - oPtr));
+}
+
+bool CFrameQueue::hasData() const
+{
+	return m_oPtr.load(std::memory_order_acquire) != m_iPtr.load(std::memory_order_acquire);
+}
+
+bool CFrameQueue::isEmpty() const
+{
+	return m_oPtr.load(std::memory_order_acquire) == m_iPtr.load(std::memory_order_acquire);
+}
+
+unsigned int CFrameQueue::getDropped() const
+{
+	return m_dropped.load(std::memory_order_relaxed);
+}
+
+unsigned int CFrameQueue::getHighWater() const
+{
+	return m_highWater.load(std::memory_order_relaxed);
+}
+
+void CFrameQueue::logStats() const
+{
+	LogInfo("%s queue: high water %u of %u bytes, %u frames dropped", m_name, getHighWater(), m_length, getDropped());
+}
+
+unsigned int CFrameQueue::skipFor(unsigned int iPtr, unsigned int length) const
+{
+	unsigned int tail = m_length - (iPtr & m_mask);
+
+	return (HEADER_LENGTH + length) > tail ? tail : 0U;
+}
+
+unsigned int CFrameQueue::frameStart(unsigned int oPtr) const
+{
+	// Step over the unused end of the buffer, either too short for a header or marked as unused
+	unsigned int ptr  = oPtr & m_mask;
+	unsigned int tail = m_length - ptr;
+
+	if (tail < HEADER_LENGTH)
+		return oPtr + tail;
+
+	unsigned int length = m_buffer[ptr + 0U] | (m_buffer[ptr + 1U] << 8);
+	if (length == WRAP_MARKER)
+		return oPtr + tail;
+
+	return oPtr;
+}
+
+unsigned int CFrameQueue::countFrames() const
+{
+	unsigned int oPtr = m_oPtr.load(std::memory_order_relaxed);
+	unsigned int iPtr = m_iPtr.load(std::memory_order_acquire);
+
+	unsigned int count = 0U;
+	while (oPtr != iPtr) {
+		oPtr = frameStart(oPtr);
+
+		unsigned int ptr = oPtr & m_mask;
+		oPtr += HEADER_LENGTH + (m_buffer[ptr + 0U] | (m_buffer[ptr + 1U] << 8));
+
+		count++;
+	}
+
+	return count;
+}
+
+bool CFrameQueue::reportOverflow()
+{
+	unsigned long long now = m_watch.time();
+	if ((now - m_lastReport) < OVERFLOW_REPORT_INTERVAL)
+		return false;
+
+	m_lastReport = now;
+
+	return true;
+}
@@ -0,0 +1,102 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#pragma once
+
+#include "StopWatch.h"
+
+#include <atomic>
+
+// The cache line size assumed when keeping the two indices apart.
+const unsigned int SPSC_CACHE_LINE = 64U;
+
+// What happens to a frame that doesn't fit, dropping the oldest frame or clearing are only safe
+// when the same thread produces and consumes. A queue shared between threads must reject.
+enum FRAME_QUEUE_OVERFLOW {
+	FQO_REJECT,
+	FQO_DROP_OLDEST,
+	FQO_CLEAR
+};
+
+// A queue of variable length byte frames, each stored whole in one contiguous piece.
+// Producers either reserve() space, fill it in place and commit() it, or use addData().
+// Consumers peek() at the next frame without copying it and pop() it when done, or use getData().
+// One thread may produce while another consumes without locking, the indices run freely and are kept
+// on their own cache lines.
+class CFrameQueue {
+public:
+	CFrameQueue(unsigned int length, const char* name, FRAME_QUEUE_OVERFLOW overflow = FQO_REJECT);
+	~CFrameQueue();
+
+	void setOverflow(FRAME_QUEUE_OVERFLOW overflow);
+
+	unsigned char* reserve(unsigned int length);
+	void commit(unsigned int length);
+
+	bool addData(const unsigned char* data, unsigned int length);
+
+	const unsigned char* peek(unsigned int& length) const;
+	void pop();
+
+	unsigned int getData(unsigned char* data);
+
+	void clear();
+
+	// The producer's position, frames committed before it can later be dropped by the consumer with clearTo()
+	unsigned int getMark() const;
+	void clearTo(unsigned int mark);
+
+	unsigned int freeSpace() const;
+	unsigned int dataSize() const;
+
+	bool hasSpace(unsigned int length) const;
+
+	bool hasData() const;
+	bool isEmpty() const;
+
+	unsigned int getDropped() const;
+	unsigned int getHighWater() const;
+
+	void logStats() const;
+
+private:
+	unsigned int              m_length;
+	unsigned int              m_mask;
+	const char*               m_name;
+	FRAME_QUEUE_OVERFLOW      m_overflow;
+	unsigned char*            m_buffer;
+	unsigned int              m_reserved;
+	unsigned int              m_skip;
+	CStopWatch                m_watch;
+	unsigned long long        m_lastReport;
+	// Kept by the producer and read from either thread
+	std::atomic<unsigned int> m_dropped;
+	std::atomic<unsigned int> m_highWater;
+	char                      m_pad1[SPSC_CACHE_LINE];
+	std::atomic<unsigned int> m_iPtr;
+	char                      m_pad2[SPSC_CACHE_LINE - sizeof(std::atomic<unsigned int>)];
+	std::atomic<unsigned int> m_oPtr;
+	char                      m_pad3[SPSC_CACHE_LINE - sizeof(std::atomic<unsigned int>)];
+
+	unsigned int skipFor(unsigned int iPtr, unsigned int length) const;
+	unsigned int frameStart(unsigned int oPtr) const;
+	unsigned int countFrames() const;
+
+	bool reportOverflow();
+};
@@ -0,0 +1 @@
+const char *gitversion = "b2311d3949";
\ No newline at end of file
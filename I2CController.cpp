@@ -95,6 +95,12 @@ int CI2CController::read(unsigned char* buffer, unsigned int length)
 	return length;
 }
 
+int CI2CController::readAvailable(unsigned char* buffer, unsigned int length)
+{
+	// The I2C bus has no receive queue to drain, so hand back a byte at a time
+	return read(buffer, length > 0U ? 1U : 0U);
+}
+
 int CI2CController::write(const unsigned char* buffer, unsigned int length)
 {
 	assert(buffer != NULL);
@@ -121,4 +127,21 @@ int CI2CController::write(const unsigned char* buffer, unsigned int length)
 	return length;
 }
 
+int CI2CController::writev(iovec* iov, unsigned int count)
+{
+	assert(iov != NULL);
+
+	int total = 0;
+
+	for (unsigned int i = 0U; i < count; i++) {
+		int n = write((unsigned char*)iov[i].iov_base, iov[i].iov_len);
+		if (n < 0)
+			return -1;
+
+		total += n;
+	}
+
+	return total;
+}
+
 #endif
@@ -32,8 +32,12 @@ public:
 
 	virtual int read(unsigned char* buffer, unsigned int length) override;
 
+	virtual int readAvailable(unsigned char* buffer, unsigned int length) override;
+
 	virtual int write(const unsigned char* buffer, unsigned int length) override;
 
+	virtual int writev(iovec* iov, unsigned int count) override;
+
 private:
 	unsigned int m_address;
 };
@@ -0,0 +1,100 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "LatencyStats.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <time.h>
+
+const unsigned int LATENCY_WINDOW = 1024U;
+
+CLatencyStats::CLatencyStats() :
+m_samples(NULL),
+m_count(0U),
+m_next(0U),
+m_total(0U)
+{
+	m_samples = new unsigned int[LATENCY_WINDOW];
+}
+
+CLatencyStats::~CLatencyStats()
+{
+	delete[] m_samples;
+}
+
+void CLatencyStats::addSample(unsigned long long timestamp)
+{
+	if (timestamp == 0ULL)
+		return;
+
+	unsigned long long end = now();
+	if (end < timestamp)
+		return;
+
+	// Held in us, anything over an hour is a clock step and not a real sample
+	unsigned long long us = (end - timestamp) / 1000ULL;
+	if (us > 3600000000ULL)
+		return;
+
+	m_samples[m_next] = (unsigned int)us;
+	m_next = (m_next + 1U) % LATENCY_WINDOW;
+	if (m_count < LATENCY_WINDOW)
+		m_count++;
+
+	m_total++;
+}
+
+void CLatencyStats::reset()
+{
+	m_count = 0U;
+	m_next  = 0U;
+	m_total = 0U;
+}
+
+void CLatencyStats::logStats(const char* name) const
+{
+	if (m_count == 0U)
+		return;
+
+	unsigned int* sorted = new unsigned int[m_count];
+	::memcpy(sorted, m_samples, m_count * sizeof(unsigned int));
+	std::sort(sorted, sorted + m_count);
+
+	unsigned long long total = 0ULL;
+	for (unsigned int i = 0U; i < m_count; i++)
+		total += sorted[i];
+
+	unsigned int p95 = sorted[(m_count * 95U) / 100U];
+	unsigned int p99 = sorted[(m_count * 99U) / 100U];
+
+	LogMessage("%s, latency over the last %u of %u frames: min %uus, avg %uus, p95 %uus, p99 %uus, max %uus", name, m_count, m_total,
+		sorted[0U], (unsigned int)(total / m_count), p95, p99, sorted[m_count - 1U]);
+
+	delete[] sorted;
+}
+
+unsigned long long CLatencyStats::now()
+{
+	struct timespec ts;
+	::clock_gettime(CLOCK_REALTIME, &ts);
+
+	return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
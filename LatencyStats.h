@@ -0,0 +1,43 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#pragma once
+
+// Time taken by frames between two points in the host, the last LATENCY_WINDOW samples are
+// kept for the percentiles. Timestamps are in ns on the realtime clock, as that is the clock
+// the kernel stamps received datagrams with.
+class CLatencyStats {
+public:
+	CLatencyStats();
+	~CLatencyStats();
+
+	// Adds the time from the timestamp until now, a zero timestamp is ignored
+	void addSample(unsigned long long timestamp);
+
+	void reset();
+
+	void logStats(const char* name) const;
+
+	static unsigned long long now();
+
+private:
+	unsigned int*  m_samples;
+	unsigned int   m_count;
+	unsigned int   m_next;
+	unsigned int   m_total;
+};
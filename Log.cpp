@@ -26,6 +26,7 @@
 #include <ctime>
 #include <cassert>
 #include <cstring>
+#include <mutex>
 #include <syslog.h>
 
 static unsigned int m_fileLevel = 2U;
@@ -42,6 +43,9 @@ static struct tm m_tm;
 
 static char LEVELS[] = " DMIWEF";
 
+// The modem I/O thread logs as well as the main thread
+static std::mutex m_mutex;
+
 static bool logOpenRotate()
 {
 	bool status = false;
@@ -128,9 +132,10 @@ void Log(unsigned int level, const char* fmt, ...)
 	struct timeval now;
 	::gettimeofday(&now, NULL);
 
-	struct tm* tm = ::gmtime(&now.tv_sec);
+	struct tm tm;
+	::gmtime_r(&now.tv_sec, &tm);
 
-	::sprintf(buffer, "%c: %04d-%02d-%02d %02d:%02d:%02d.000 ", LEVELS[level], tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec);
+	::sprintf(buffer, "%c: %04d-%02d-%02d %02d:%02d:%02d.000 ", LEVELS[level], tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
 
 	va_list vl;
 	va_start(vl, fmt);
@@ -139,6 +144,8 @@ void Log(unsigned int level, const char* fmt, ...)
 
 	va_end(vl);
 
+	std::lock_guard<std::mutex> lock(m_mutex);
+
 	if (level >= m_fileLevel && m_fileLevel != 0U) {
 		bool ret = ::LogOpen();
 		if (!ret)
@@ -18,6 +18,8 @@
 
 #include "MMDVMHost.h"
 #include "RSSIInterpolator.h"
+#include "DNSResolver.h"
+#include "EventLoop.h"
 #include "SerialController.h"
 #include "Version.h"
 #include "StopWatch.h"
@@ -30,6 +32,7 @@
 #include <vector>
 
 #include <cstdlib>
+#include <cassert>
 
 #include <sys/types.h>
 #include <unistd.h>
@@ -39,6 +42,13 @@
 
 const char* DEFAULT_INI_FILE = "/etc/MMDVM.ini";
 
+// Upper bounds on how long the main loop sleeps when no descriptor is readable
+const unsigned int LOOP_IDLE_TIMEOUT = 100U;
+const unsigned int LOOP_BUSY_TIMEOUT = 5U;
+
+// getaddrinfo() gives no TTL, so resolved names are refreshed on a fixed period
+const unsigned int DNS_REFRESH_SECS = 300U;
+
 static bool m_killed = false;
 static int  m_signal = 0;
 
@@ -100,7 +110,7 @@ m_conf(confFile),
 m_modem(NULL),
 m_dmr(NULL),
 m_pocsag(NULL),
-m_dmrNetwork(NULL),
+m_dmrNetworks(),
 m_pocsagNetwork(NULL),
 m_display(NULL),
 m_mode(MODE_IDLE),
@@ -123,6 +133,7 @@ m_cwCallsign()
 
 CMMDVMHost::~CMMDVMHost()
 {
+	CDNSResolver::stop();
 }
 
 int CMMDVMHost::run()
@@ -167,6 +178,9 @@ int CMMDVMHost::run()
 		m_pocsagEnabled = false;
 	}
 
+	// Name lookups from here on are done away from the main loop
+	CDNSResolver::start(DNS_REFRESH_SECS);
+
 	m_display = CDisplay::createDisplay(m_conf,m_modem);
 
 	if (m_dmrEnabled && m_conf.getDMRNetworkEnabled()) {
@@ -320,7 +334,11 @@ int CMMDVMHost::run()
 				break;
 		}
 
-		m_dmr = new CDMRControl(id, colorCode, callHang, selfOnly, embeddedLCOnly, dumpTAData, prefixes, blackList, whiteList, slot1TGWhiteList, slot2TGWhiteList, m_timeout, m_modem, m_dmrNetwork, m_display, m_duplex, rssi, ovcm);
+		// The jitter buffer only applies to network traffic
+		unsigned int jitter = !m_dmrNetworks.empty() ? m_conf.getDMRNetworkJitter() : 0U;
+		unsigned int slotBudget = m_conf.getDMRNetworkSlotBudget();
+
+		m_dmr = new CDMRControl(id, colorCode, callHang, selfOnly, embeddedLCOnly, dumpTAData, prefixes, blackList, whiteList, slot1TGWhiteList, slot2TGWhiteList, m_timeout, jitter, slotBudget, m_modem, m_dmrNetworks, m_display, m_duplex, rssi, ovcm);
 
 		m_dmrTXTimer.setTimeout(txHang);
 	}
@@ -341,9 +359,30 @@ int CMMDVMHost::run()
 
 	setMode(MODE_IDLE);
 
+	CEventLoop eventLoop;
+
 	LogMessage("DMRHost-%s is running", VERSION);
 
 	while (!m_killed) {
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+		m_display->clock(ms);
+
+		unsigned int frames = m_modem->clock(ms);
+
+		m_modeTimer.clock(ms);
+
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->clock(ms);
+		if (m_pocsagNetwork != NULL)
+			m_pocsagNetwork->clock(ms);
+
+		if (m_dmr != NULL)
+			m_dmr->clock();
+		if (m_pocsag != NULL)
+			m_pocsag->clock(ms);
+
 		bool error = m_modem->hasError();
 		if (error && m_mode != MODE_ERROR)
 			setMode(MODE_ERROR);
@@ -352,9 +391,12 @@ int CMMDVMHost::run()
 
 		unsigned char data[220U];
 		unsigned int len;
+		unsigned long long timestamp;
+
+		while ((len = m_modem->readDMRData1(data, timestamp)) > 0U) {
+			if (m_dmr == NULL)
+				continue;
 
-		len = m_modem->readDMRData1(data);
-		if (m_dmr != NULL && len > 0U) {
 			if (m_mode == MODE_IDLE) {
 				if (m_duplex) {
 					ret = m_dmr->processWakeup(data);
@@ -366,7 +408,7 @@ int CMMDVMHost::run()
 				} else {
 					m_modeTimer.setTimeout(m_dmrRFModeHang);
 					setMode(MODE_DMR);
-					m_dmr->writeModemSlot1(data, len);
+					m_dmr->writeModemSlot1(data, len, timestamp);
 					dmrBeaconDurationTimer.stop();
 				}
 			} else if (m_mode == MODE_DMR) {
@@ -377,7 +419,7 @@ int CMMDVMHost::run()
 						m_dmrTXTimer.start();
 					}
 				} else {
-					ret = m_dmr->writeModemSlot1(data, len);
+					ret = m_dmr->writeModemSlot1(data, len, timestamp);
 					if (ret) {
 						dmrBeaconDurationTimer.stop();
 						m_modeTimer.start();
@@ -388,8 +430,10 @@ int CMMDVMHost::run()
 			}
 		}
 
-		len = m_modem->readDMRData2(data);
-		if (m_dmr != NULL && len > 0U) {
+		while ((len = m_modem->readDMRData2(data, timestamp)) > 0U) {
+			if (m_dmr == NULL)
+				continue;
+
 			if (m_mode == MODE_IDLE) {
 				if (m_duplex) {
 					ret = m_dmr->processWakeup(data);
@@ -401,7 +445,7 @@ int CMMDVMHost::run()
 				} else {
 					m_modeTimer.setTimeout(m_dmrRFModeHang);
 					setMode(MODE_DMR);
-					m_dmr->writeModemSlot2(data, len);
+					m_dmr->writeModemSlot2(data, len, timestamp);
 					dmrBeaconDurationTimer.stop();
 				}
 			} else if (m_mode == MODE_DMR) {
@@ -412,7 +456,7 @@ int CMMDVMHost::run()
 						m_dmrTXTimer.start();
 					}
 				} else {
-					ret = m_dmr->writeModemSlot2(data, len);
+					ret = m_dmr->writeModemSlot2(data, len, timestamp);
 					if (ret) {
 						dmrBeaconDurationTimer.stop();
 						m_modeTimer.start();
@@ -423,9 +467,10 @@ int CMMDVMHost::run()
 			}
 		}
 
-		len = m_modem->readTransparentData(data);
-		if (transparentSocket != NULL && len > 0U)
-			transparentSocket->write(data, len, transparentAddress, transparentAddrLen);
+		while ((len = m_modem->readTransparentData(data)) > 0U) {
+			if (transparentSocket != NULL)
+				transparentSocket->write(data, len, transparentAddress, transparentAddrLen);
+		}
 
 		if (m_modeTimer.isRunning() && m_modeTimer.hasExpired() && !m_modem->hasTX())
 			setMode(MODE_IDLE);
@@ -433,7 +478,7 @@ int CMMDVMHost::run()
 		if (m_dmr != NULL) {
 			ret = m_modem->hasDMRSpace1();
 			if (ret) {
-				len = m_dmr->readModemSlot1(data);
+				len = m_dmr->readModemSlot1(data, timestamp);
 				if (len > 0U) {
 					if (m_mode == MODE_IDLE) {
 						m_modeTimer.setTimeout(m_dmrNetModeHang);
@@ -444,7 +489,7 @@ int CMMDVMHost::run()
 							m_modem->writeDMRStart(true);
 							m_dmrTXTimer.start();
 						}
-						m_modem->writeDMRData1(data, len);
+						m_modem->writeDMRData1(data, len, timestamp);
 						dmrBeaconDurationTimer.stop();
 						m_modeTimer.start();
 					}
@@ -453,7 +498,7 @@ int CMMDVMHost::run()
 
 			ret = m_modem->hasDMRSpace2();
 			if (ret) {
-				len = m_dmr->readModemSlot2(data);
+				len = m_dmr->readModemSlot2(data, timestamp);
 				if (len > 0U) {
 					if (m_mode == MODE_IDLE) {
 						m_modeTimer.setTimeout(m_dmrNetModeHang);
@@ -464,7 +509,7 @@ int CMMDVMHost::run()
 							m_modem->writeDMRStart(true);
 							m_dmrTXTimer.start();
 						}
-						m_modem->writeDMRData2(data, len);
+						m_modem->writeDMRData2(data, len, timestamp);
 						dmrBeaconDurationTimer.stop();
 						m_modeTimer.start();
 					}
@@ -496,25 +541,6 @@ int CMMDVMHost::run()
 				m_modem->writeTransparentData(data, len);
 		}
 
-		unsigned int ms = stopWatch.elapsed();
-		stopWatch.start();
-
-		m_display->clock(ms);
-
-		m_modem->clock(ms);
-
-		m_modeTimer.clock(ms);
-
-		if (m_dmr != NULL)
-			m_dmr->clock();
-		if (m_pocsag != NULL)
-			m_pocsag->clock(ms);
-
-		if (m_dmrNetwork != NULL)
-			m_dmrNetwork->clock(ms);
-		if (m_pocsagNetwork != NULL)
-			m_pocsagNetwork->clock(ms);
-
 		m_cwIdTimer.clock(ms);
 		if (m_cwIdTimer.isRunning() && m_cwIdTimer.hasExpired()) {
 			if (!m_modem->hasTX()){
@@ -529,8 +555,8 @@ int CMMDVMHost::run()
 
 		switch (dmrBeacons) {
 			case DMR_BEACONS_NETWORK:
-				if (m_dmrNetwork != NULL) {
-					bool beacon = m_dmrNetwork->wantsBeacon();
+				for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it) {
+					bool beacon = (*it)->wantsBeacon();
 					if (beacon) {
 						if ((m_mode == MODE_IDLE || m_mode == MODE_DMR) && !m_modem->hasTX()) {
 							if (m_mode == MODE_IDLE)
@@ -563,8 +589,41 @@ int CMMDVMHost::run()
 			pocsagTimer.start();
 		}
 
-		if (ms < 5U)
-			usleep(5 * 1000);
+		// Send everything queued for the masters during this pass together
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->flush();
+
+		// Sleep until the modem or a socket has data, or the next timer is due
+		unsigned int timeout = LOOP_IDLE_TIMEOUT;
+		if (m_mode != MODE_IDLE || m_modem->hasTX())
+			timeout = LOOP_BUSY_TIMEOUT;
+
+		unsigned int modemTimeout = m_modem->getTimeout();
+		if (modemTimeout < timeout)
+			timeout = modemTimeout;
+
+		if (m_dmr != NULL) {
+			unsigned int dmrTimeout = m_dmr->getTimeout();
+			if (dmrTimeout < timeout)
+				timeout = dmrTimeout;
+		}
+
+		// Frames from the modem may have queued replies for it, go round again without waiting
+		if (frames > 0U)
+			timeout = 0U;
+
+		// The network display's socket is left out, it is only ever written to and a stray datagram
+		// that nothing reads would keep waking the loop
+		eventLoop.clear();
+		eventLoop.add(m_modem->getFd());
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			eventLoop.add((*it)->getFd());
+		if (m_pocsagNetwork != NULL)
+			eventLoop.add(m_pocsagNetwork->getFd());
+		if (transparentSocket != NULL)
+			eventLoop.add(transparentSocket->getFd());
+
+		eventLoop.wait(timeout);
 	}
 
 	setMode(MODE_QUIT);
@@ -575,9 +634,9 @@ int CMMDVMHost::run()
 	m_display->close();
 	delete m_display;
 
-	if (m_dmrNetwork != NULL) {
-		m_dmrNetwork->close();
-		delete m_dmrNetwork;
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it) {
+		(*it)->close();
+		delete *it;
 	}
 
 	if (m_pocsagNetwork != NULL) {
@@ -612,6 +671,8 @@ bool CMMDVMHost::createModem()
 	float pocsagTXLevel          = m_conf.getModemPOCSAGTXLevel();
 	bool trace                   = m_conf.getModemTrace();
 	bool debug                   = m_conf.getModemDebug();
+	bool ioThread                = m_conf.getModemIOThread();
+	unsigned int frameBudget     = m_conf.getModemFrameBudget();
 	unsigned int colorCode       = m_conf.getDMRColorCode();
 	unsigned int rxFrequency     = m_conf.getRXFrequency();
 	unsigned int txFrequency     = m_conf.getTXFrequency();
@@ -642,6 +703,11 @@ bool CMMDVMHost::createModem()
 	LogInfo("    DMR TX Level: %.1f%%", dmrTXLevel);
 	LogInfo("    POCSAG TX Level: %.1f%%", pocsagTXLevel);
 	LogInfo("    TX Frequency: %uHz (%uHz)", txFrequency, txFrequency + txOffset);
+	LogInfo("    I/O Thread: %s", ioThread ? "yes" : "no");
+	if (frameBudget > 0U)
+		LogInfo("    Frame Budget: %u", frameBudget);
+	else
+		LogInfo("    Frame Budget: unlimited");
 
 	if (m_duplex && rxFrequency == txFrequency) {
 		LogError("Duplex == 1 and TX == RX-QRG!");
@@ -659,6 +725,7 @@ bool CMMDVMHost::createModem()
 	m_modem->setLevels(rxLevel, cwIdTXLevel, dmrTXLevel, pocsagTXLevel);
 	m_modem->setRFParams(rxFrequency, rxOffset, txFrequency, txOffset, txDCOffset, rxDCOffset, rfLevel, pocsagFrequency);
 	m_modem->setDMRParams(colorCode);
+	m_modem->setIOParams(ioThread, frameBudget);
 
 	bool ret = m_modem->open();
 	if (!ret) {
@@ -681,20 +748,91 @@ bool CMMDVMHost::createDMRNetwork()
 	bool slot2           = m_conf.getDMRNetworkSlot2();
 	const char* hwType   = m_modem->getHWType();
 	m_dmrNetModeHang     = m_conf.getDMRNetworkModeHang();
+	unsigned int jitter  = m_conf.getDMRNetworkJitter();
+	std::vector<std::pair<unsigned int, unsigned int>> tgRanges = m_conf.getDMRNetworkTGRanges();
+	unsigned int rxBuffer = m_conf.getDMRNetworkRecvBuffer();
+	unsigned int txBuffer = m_conf.getDMRNetworkSendBuffer();
+	unsigned int dscp     = m_conf.getDMRNetworkDSCP();
+	unsigned int priority = m_conf.getDMRNetworkPriority();
+	unsigned int busyPoll = m_conf.getDMRNetworkBusyPoll();
 
 	LogInfo("DMR Network Parameters");
 	LogInfo("    Address: %s", address.c_str());
 	LogInfo("    Port: %hu", port);
 	LogInfo("    Slot 1: %s", slot1 ? "enabled" : "disabled");
 	LogInfo("    Slot 2: %s", slot2 ? "enabled" : "disabled");
+	for (std::vector<std::pair<unsigned int, unsigned int>>::const_iterator it = tgRanges.begin(); it != tgRanges.end(); ++it)
+		LogInfo("    TG Range: %u-%u", it->first, it->second);
 	LogInfo("    Mode Hang: %us", m_dmrNetModeHang);
-
-	m_dmrNetwork = new CDMRNetwork(address, port, id, password, m_duplex, VERSION, debug, slot1, slot2, hwType);
+	if (jitter > 0U)
+		LogInfo("    Jitter: %ums", jitter);
+	else
+		LogInfo("    Jitter: disabled");
+	unsigned int slotBudget = m_conf.getDMRNetworkSlotBudget();
+	if (slotBudget > 0U)
+		LogInfo("    Slot Budget: %u frames", slotBudget);
+	else
+		LogInfo("    Slot Budget: unlimited");
+	if (rxBuffer > 0U)
+		LogInfo("    Receive Buffer: %u bytes", rxBuffer);
+	if (txBuffer > 0U)
+		LogInfo("    Send Buffer: %u bytes", txBuffer);
+	if (dscp > 0U)
+		LogInfo("    DSCP: %u", dscp);
+	if (priority > 0U)
+		LogInfo("    Priority: %u", priority);
+	if (busyPoll > 0U)
+		LogInfo("    Busy Poll: %uus", busyPoll);
+
+	CDMRNetwork* network = new CDMRNetwork(address, port, id, password, m_duplex, VERSION, debug, slot1, slot2, hwType);
+	network->setTGRanges(tgRanges);
+	m_dmrNetworks.push_back(network);
+
+	std::string secondaryAddress  = m_conf.getDMRNetworkSecondaryAddress();
+	unsigned short secondaryPort  = m_conf.getDMRNetworkSecondaryPort();
+	std::string secondaryPassword = m_conf.getDMRNetworkSecondaryPassword();
+	if (!secondaryAddress.empty() && secondaryPort > 0U) {
+		if (secondaryPassword.empty())
+			secondaryPassword = password;
+
+		LogInfo("    Secondary Address: %s", secondaryAddress.c_str());
+		LogInfo("    Secondary Port: %hu", secondaryPort);
+		network->setSecondary(secondaryAddress, secondaryPort, secondaryPassword);
+	}
 
 	std::string options = m_conf.getDMRNetworkOptions();
 	if (!options.empty()) {
 		LogInfo("    Options: %s", options.c_str());
-		m_dmrNetwork->setOptions(options);
+		network->setOptions(options);
+	}
+
+	// A second session takes the slots and talkgroups routed to it directly, without an external gateway
+	if (m_conf.getDMRNetwork2Enabled()) {
+		address  = m_conf.getDMRNetwork2Address();
+		port     = m_conf.getDMRNetwork2Port();
+		password = m_conf.getDMRNetwork2Password();
+		debug    = m_conf.getDMRNetwork2Debug();
+		slot1    = m_conf.getDMRNetwork2Slot1();
+		slot2    = m_conf.getDMRNetwork2Slot2();
+		tgRanges = m_conf.getDMRNetwork2TGRanges();
+
+		LogInfo("DMR Network 2 Parameters");
+		LogInfo("    Address: %s", address.c_str());
+		LogInfo("    Port: %hu", port);
+		LogInfo("    Slot 1: %s", slot1 ? "enabled" : "disabled");
+		LogInfo("    Slot 2: %s", slot2 ? "enabled" : "disabled");
+		for (std::vector<std::pair<unsigned int, unsigned int>>::const_iterator it = tgRanges.begin(); it != tgRanges.end(); ++it)
+			LogInfo("    TG Range: %u-%u", it->first, it->second);
+
+		network = new CDMRNetwork(address, port, id, password, m_duplex, VERSION, debug, slot1, slot2, hwType);
+		network->setTGRanges(tgRanges);
+		m_dmrNetworks.push_back(network);
+
+		options = m_conf.getDMRNetwork2Options();
+		if (!options.empty()) {
+			LogInfo("    Options: %s", options.c_str());
+			network->setOptions(options);
+		}
 	}
 
 	unsigned int rxFrequency = m_conf.getRXFrequency();
@@ -720,16 +858,25 @@ bool CMMDVMHost::createDMRNetwork()
 	LogInfo("    Description: \"%s\"", description.c_str());
 	LogInfo("    URL: \"%s\"", url.c_str());
 
-	m_dmrNetwork->setConfig(m_callsign, rxFrequency, txFrequency, power, colorCode, latitude, longitude, height, location, description, url);
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it) {
+		(*it)->setSocketOptions(rxBuffer, txBuffer, dscp, priority, busyPoll);
+		(*it)->setConfig(m_callsign, rxFrequency, txFrequency, power, colorCode, latitude, longitude, height, location, description, url);
 
-	bool ret = m_dmrNetwork->open();
-	if (!ret) {
-		delete m_dmrNetwork;
-		m_dmrNetwork = NULL;
-		return false;
+		bool ret = (*it)->open();
+		if (!ret) {
+			// The sessions before this one are already open
+			for (std::vector<CDMRNetwork*>::const_iterator it2 = m_dmrNetworks.begin(); it2 != it; ++it2)
+				(*it2)->close();
+
+			for (std::vector<CDMRNetwork*>::const_iterator it2 = m_dmrNetworks.begin(); it2 != m_dmrNetworks.end(); ++it2)
+				delete *it2;
+			m_dmrNetworks.clear();
+			return false;
+		}
 	}
 
-	m_dmrNetwork->enable(true);
+	for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+		(*it)->enable(true);
 
 	return true;
 }
@@ -789,8 +936,8 @@ void CMMDVMHost::setMode(unsigned char mode)
 
 	switch (mode) {
 	case MODE_DMR:
-		if (m_dmrNetwork != NULL)
-			m_dmrNetwork->enable(true);
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->enable(true);
 		if (m_pocsagNetwork != NULL)
 			m_pocsagNetwork->enable(false);
 		if (m_dmr != NULL)
@@ -808,8 +955,8 @@ void CMMDVMHost::setMode(unsigned char mode)
 		break;
 
 	case MODE_POCSAG:
-		if (m_dmrNetwork != NULL)
-			m_dmrNetwork->enable(false);
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->enable(false);
 		if (m_pocsagNetwork != NULL)
 			m_pocsagNetwork->enable(true);
 		if (m_dmr != NULL)
@@ -824,8 +971,8 @@ void CMMDVMHost::setMode(unsigned char mode)
 
 	case MODE_ERROR:
 		LogMessage("Mode set to Error");
-		if (m_dmrNetwork != NULL)
-			m_dmrNetwork->enable(false);
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->enable(false);
 		if (m_pocsagNetwork != NULL)
 			m_pocsagNetwork->enable(false);
 		if (m_dmr != NULL)
@@ -843,8 +990,8 @@ void CMMDVMHost::setMode(unsigned char mode)
 		break;
 
 	default:
-		if (m_dmrNetwork != NULL)
-			m_dmrNetwork->enable(true);
+		for (std::vector<CDMRNetwork*>::const_iterator it = m_dmrNetworks.begin(); it != m_dmrNetworks.end(); ++it)
+			(*it)->enable(true);
 		if (m_pocsagNetwork != NULL)
 			m_pocsagNetwork->enable(true);
 		if (m_dmr != NULL)
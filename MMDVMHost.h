@@ -28,6 +28,7 @@
 #include "Conf.h"
 
 #include <string>
+#include <vector>
 
 
 class CMMDVMHost
@@ -43,7 +44,7 @@ private:
   CModem*         m_modem;
   CDMRControl*    m_dmr;
   CPOCSAGControl* m_pocsag;
-  CDMRNetwork*    m_dmrNetwork;
+  std::vector<CDMRNetwork*> m_dmrNetworks;
   CPOCSAGNetwork* m_pocsagNetwork;
   CDisplay*       m_display;
   unsigned char   m_mode;
@@ -19,6 +19,7 @@
 #include "I2CController.h"
 #include "DMRDefines.h"
 #include "POCSAGDefines.h"
+#include "StopWatch.h"
 #include "Modem.h"
 #include "NullModem.h"
 #include "Utils.h"
@@ -28,9 +29,12 @@
 #include <cstdio>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <ctime>
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 
 const unsigned char MMDVM_FRAME_START = 0xE0U;
 
@@ -70,6 +74,13 @@ const unsigned int MAX_RESPONSES = 30U;
 
 const unsigned int BUFFER_LENGTH = 2000U;
 
+const unsigned int TX_BATCH_FRAMES = 16U;
+
+// DMR frames in the queues are preceded by the time they reached the host
+const unsigned int TIMESTAMP_LENGTH = sizeof(unsigned long long);
+
+const unsigned int LATENCY_STATS_INTERVAL = 900U;
+
 const unsigned char CAP1_DMR    = 0x02U;
 const unsigned char CAP2_POCSAG = 0x01U;
 
@@ -101,7 +112,12 @@ m_txDCOffset(0),
 m_serial(NULL),
 m_buffer(NULL),
 m_length(0U),
-m_offset(0U),
+m_rxBuffer(NULL),
+m_rxLength(0U),
+m_txBuffer(NULL),
+m_txIOV(NULL),
+m_txTimestamps(NULL),
+m_rxTimestamp(0ULL),
 m_rxDMRData1(1000U, "Modem RX DMR1"),
 m_rxDMRData2(1000U, "Modem RX DMR2"),
 m_txDMRData1(1000U, "Modem TX DMR1"),
@@ -109,10 +125,16 @@ m_txDMRData2(1000U, "Modem TX DMR2"),
 m_txPOCSAGData(1000U, "Modem TX POCSAG"),
 m_rxTransparentData(1000U, "Modem RX Transparent"),
 m_txTransparentData(1000U, "Modem TX Transparent"),
+m_txCommand(1000U, "Modem TX Command"),
 m_sendTransparentDataFrameType(0U),
 m_statusTimer(1000U, 0U, 250U),
 m_inactivityTimer(1000U, 2U),
 m_playoutTimer(1000U, 0U, 10U),
+m_recoveryTimer(1000U),
+m_latencyTimer(1000U, LATENCY_STATS_INTERVAL),
+m_netLatency(),
+m_recovery(MR_NONE),
+m_recoveryCount(0U),
 m_dmrSpace1(0U),
 m_dmrSpace2(0U),
 m_pocsagSpace(0U),
@@ -121,17 +143,37 @@ m_error(false),
 m_mode(MODE_IDLE),
 m_hwType("MMDVM_Unknown"),
 m_capabilities1(0x00U),
-m_capabilities2(0x00U)
+m_capabilities2(0x00U),
+m_ioThread(false),
+m_frameBudget(0U),
+m_rxFrames(0U),
+m_thread(),
+m_running(false),
+m_rxNotify(),
+m_txNotify()
 {
-	m_buffer = new unsigned char[BUFFER_LENGTH];
+	m_buffer   = new unsigned char[BUFFER_LENGTH];
+	m_rxBuffer = new unsigned char[BUFFER_LENGTH];
+	m_txBuffer = new unsigned char[TX_BATCH_FRAMES * 256U];
+	m_txIOV    = new iovec[TX_BATCH_FRAMES];
+	m_txTimestamps = new unsigned long long[TX_BATCH_FRAMES];
+
+	m_rxNotify[0U] = m_rxNotify[1U] = -1;
+	m_txNotify[0U] = m_txNotify[1U] = -1;
 
 	assert(!port.empty());
 }
 
 CModem::~CModem()
 {
+	stopThread();
+
 	delete   m_serial;
 	delete[] m_buffer;
+	delete[] m_rxBuffer;
+	delete[] m_txBuffer;
+	delete[] m_txIOV;
+	delete[] m_txTimestamps;
 }
 
 void CModem::setSerialParams(const std::string& protocol, unsigned int address)
@@ -181,7 +223,33 @@ void CModem::setTransparentDataParams(unsigned int sendFrameType)
     m_sendTransparentDataFrameType = sendFrameType;
 }
 
+void CModem::setIOParams(bool ioThread, unsigned int frameBudget)
+{
+	m_ioThread    = ioThread;
+	m_frameBudget = frameBudget;
+
+	// Without the I/O thread the TX queues are filled and emptied by the same thread, so a late
+	// burst can push out the oldest frame instead of being lost. With it only the consumer may
+	// move the read index, so these and every other modem queue reject what doesn't fit.
+	FRAME_QUEUE_OVERFLOW overflow = ioThread ? FQO_REJECT : FQO_DROP_OLDEST;
+	m_txDMRData1.setOverflow(overflow);
+	m_txDMRData2.setOverflow(overflow);
+	m_txPOCSAGData.setOverflow(overflow);
+}
+
 bool CModem::open()
+{
+	bool ret = openInt();
+	if (!ret)
+		return false;
+
+	if (m_ioThread)
+		return startThread();
+
+	return true;
+}
+
+bool CModem::openInt()
 {
 	::LogMessage("Opening the MMDVM");
 
@@ -192,8 +260,6 @@ bool CModem::open()
 	ret = readVersion();
 	if (!ret) {
 		m_serial->close();
-		delete m_serial;
-		m_serial = NULL;
 		return false;
 	} else {
 		/* Stopping the inactivity timer here when a firmware version has been
@@ -204,31 +270,46 @@ bool CModem::open()
 	ret = setFrequency();
 	if (!ret) {
 		m_serial->close();
-		delete m_serial;
-		m_serial = NULL;
 		return false;
 	}
 
 	ret = writeConfig();
 	if (!ret) {
 		m_serial->close();
-		delete m_serial;
-		m_serial = NULL;
 		return false;
 	}
 
 	m_statusTimer.start();
+	m_latencyTimer.start();
 
-	m_error  = false;
-	m_offset = 0U;
+	m_error    = false;
+	m_rxLength = 0U;
 
 	return true;
 }
 
-void CModem::clock(unsigned int ms)
+unsigned int CModem::clock(unsigned int ms)
+{
+	// The I/O thread drives the modem, only its wakeups need to be consumed here
+	if (m_running) {
+		unsigned char buffer[50U];
+		while (::read(m_rxNotify[0U], buffer, 50U) > 0)
+			;
+		return m_rxFrames.exchange(0U);
+	}
+
+	return clockInt(ms);
+}
+
+unsigned int CModem::clockInt(unsigned int ms)
 {
 	assert(m_serial != NULL);
 
+	if (m_recovery != MR_NONE) {
+		clockRecovery(ms);
+		return 0U;
+	}
+
 	// Poll the modem status every 250ms
 	m_statusTimer.clock(ms);
 	if (m_statusTimer.hasExpired()) {
@@ -236,344 +317,692 @@ void CModem::clock(unsigned int ms)
 		m_statusTimer.start();
 	}
 
+	m_latencyTimer.clock(ms);
+	if (m_latencyTimer.isRunning() && m_latencyTimer.hasExpired()) {
+		m_netLatency.logStats("DMR, network to modem");
+		m_latencyTimer.start();
+	}
+
 	m_inactivityTimer.clock(ms);
 	if (m_inactivityTimer.hasExpired()) {
 		LogError("No reply from the modem for some time, resetting it");
 		m_error = true;
-		close();
+		m_tx    = false;
+		closeInt();
 
-		usleep(2000 * 1000);		// 2s
-		while (!open())
-			usleep(5000 * 1000);	// 5s
+		m_recovery = MR_WAIT_OPEN;
+		m_recoveryTimer.setTimeout(2U);
+		m_recoveryTimer.start();
+		return 0U;
 	}
 
-	RESP_TYPE_MMDVM type = getResponse();
+	// Handle every complete frame the modem has sent, up to the budget
+	unsigned int frames = 0U;
+	while (m_frameBudget == 0U || frames < m_frameBudget) {
+		RESP_TYPE_MMDVM type = getResponse();
+		if (type != RTM_OK)
+			break;
 
-	if (type == RTM_TIMEOUT) {
-		// Nothing to do
-	} else if (type == RTM_ERROR) {
-		// Nothing to do
-	} else {
-		// type == RTM_OK
-		switch (m_buffer[2U]) {
-			case MMDVM_DMR_DATA1: {
-					if (m_trace)
-						CUtils::dump(1U, "RX DMR Data 1", m_buffer, m_length);
-
-					unsigned char data = m_length - 2U;
-					m_rxDMRData1.addData(&data, 1U);
-
-					if (m_buffer[3U] == (DMR_SYNC_DATA | DT_TERMINATOR_WITH_LC))
-						data = TAG_EOT;
-					else
-						data = TAG_DATA;
-					m_rxDMRData1.addData(&data, 1U);
-
-					m_rxDMRData1.addData(m_buffer + 3U, m_length - 3U);
-				}
-				break;
+		processResponse();
+		frames++;
+	}
 
-			case MMDVM_DMR_DATA2: {
-					if (m_trace)
-						CUtils::dump(1U, "RX DMR Data 2", m_buffer, m_length);
+	// Commands queued by the host thread go out straight away
+	unsigned int len = 0U;
+	const unsigned char* buffer;
+	while ((buffer = m_txCommand.peek(len)) != NULL) {
+		// An abort flushes the frames queued for that slot before it was issued, it carries the queue
+		// position after the command itself
+		if (buffer[2U] == MMDVM_DMR_ABORT) {
+			unsigned int mark;
+			::memcpy(&mark, buffer + 4U, sizeof(mark));
+
+			if (buffer[3U] == 1U)
+				m_txDMRData1.clearTo(mark);
+			else
+				m_txDMRData2.clearTo(mark);
+
+			len = buffer[1U];
+		}
 
-					unsigned char data = m_length - 2U;
-					m_rxDMRData2.addData(&data, 1U);
+		int ret = m_serial->write(buffer, len);
+		if (ret != int(len))
+			LogWarning("Error when writing a command to the MMDVM");
 
-					if (m_buffer[3U] == (DMR_SYNC_DATA | DT_TERMINATOR_WITH_LC))
-						data = TAG_EOT;
-					else
-						data = TAG_DATA;
-					m_rxDMRData2.addData(&data, 1U);
+		m_txCommand.pop();
+	}
 
-					m_rxDMRData2.addData(m_buffer + 3U, m_length - 3U);
-				}
+	// Only feed data to the modem if the playout timer has expired
+	m_playoutTimer.clock(ms);
+	if (!m_playoutTimer.hasExpired())
+		return frames;
+
+	// Gather every frame the modem has room for, taking the queues in turn, and send them together
+	unsigned int count = 0U;
+	unsigned int offset = 0U;
+
+	// Each round takes up to three frames, and one transparent frame may follow
+	bool more = true;
+	while (more && (count + 4U) <= TX_BATCH_FRAMES) {
+		more = false;
+
+		if (m_dmrSpace1 > 1U && !m_txDMRData1.isEmpty()) {
+			gatherTX(m_txDMRData1, "TX DMR Data 1", true, count, offset);
+			m_dmrSpace1--;
+			more = true;
+		}
+
+		if (m_dmrSpace2 > 1U && !m_txDMRData2.isEmpty()) {
+			gatherTX(m_txDMRData2, "TX DMR Data 2", true, count, offset);
+			m_dmrSpace2--;
+			more = true;
+		}
+
+		if (m_pocsagSpace > 1U && !m_txPOCSAGData.isEmpty()) {
+			gatherTX(m_txPOCSAGData, "TX POCSAG Data", false, count, offset);
+			m_pocsagSpace--;
+			more = true;
+		}
+	}
+
+	// Only frames with buffer credit are paced by the playout timer
+	if (count > 0U)
+		m_playoutTimer.start();
+
+	if (!m_txTransparentData.isEmpty())
+		gatherTX(m_txTransparentData, "TX Transparent Data", false, count, offset);
+
+	if (count > 0U) {
+		int ret = m_serial->writev(m_txIOV, count);
+		if (ret != int(offset)) {
+			LogWarning("Error when writing data to the MMDVM");
+		} else {
+			for (unsigned int i = 0U; i < count; i++)
+				m_netLatency.addSample(m_txTimestamps[i]);
+		}
+	}
+
+	return frames;
+}
+
+void CModem::clockRecovery(unsigned int ms)
+{
+	// Nothing queued while the modem was away is still relevant
+	m_txDMRData1.clear();
+	m_txDMRData2.clear();
+	m_txPOCSAGData.clear();
+	m_txTransparentData.clear();
+	m_txCommand.clear();
+
+	m_recoveryTimer.clock(ms);
+
+	if (m_recovery == MR_WAIT_OPEN) {
+		if (!m_recoveryTimer.hasExpired())
+			return;
+
+		::LogMessage("Opening the MMDVM");
+
+		bool ret = m_serial->open();
+		if (!ret) {
+			m_recoveryTimer.setTimeout(5U);
+			m_recoveryTimer.start();
+			return;
+		}
+
+		m_rxLength = 0U;
+
+		// Give the firmware time to boot before asking for its version
+		m_recovery = MR_WAIT_VERSION;
+		m_recoveryCount = 0U;
+		m_recoveryTimer.setTimeout(2U);
+		m_recoveryTimer.start();
+		return;
+	}
+
+	// Each step sends its command and moves on, the reply is picked up on a later clock
+	while (getResponse() == RTM_OK) {
+		switch (m_recovery) {
+		case MR_WAIT_VERSION:
+			if (m_buffer[2U] != MMDVM_GET_VERSION)
 				break;
 
-			case MMDVM_DMR_LOST1: {
-					if (m_trace)
-						CUtils::dump(1U, "RX DMR Lost 1", m_buffer, m_length);
+			if (!processVersion() || !sendFrequency()) {
+				retryRecovery();
+				return;
+			}
+
+			m_recovery = MR_WAIT_FREQ;
+			m_recoveryTimer.setTimeout(1U);
+			m_recoveryTimer.start();
+			break;
 
-					unsigned char data = 1U;
-					m_rxDMRData1.addData(&data, 1U);
+		case MR_WAIT_FREQ:
+			if (m_buffer[2U] == MMDVM_NAK) {
+				LogError("Received a NAK to the SET_FREQ command from the modem");
+				retryRecovery();
+				return;
+			}
 
-					data = TAG_LOST;
-					m_rxDMRData1.addData(&data, 1U);
-				}
+			if (m_buffer[2U] != MMDVM_ACK)
 				break;
 
-			case MMDVM_DMR_LOST2: {
-					if (m_trace)
-						CUtils::dump(1U, "RX DMR Lost 2", m_buffer, m_length);
+			if (!sendConfig()) {
+				retryRecovery();
+				return;
+			}
 
-					unsigned char data = 1U;
-					m_rxDMRData2.addData(&data, 1U);
+			m_recovery = MR_WAIT_CONFIG;
+			m_recoveryTimer.setTimeout(1U);
+			m_recoveryTimer.start();
+			break;
 
-					data = TAG_LOST;
-					m_rxDMRData2.addData(&data, 1U);
-				}
+		case MR_WAIT_CONFIG:
+			if (m_buffer[2U] == MMDVM_NAK) {
+				LogError("Received a NAK to the SET_CONFIG command from the modem");
+				retryRecovery();
+				return;
+			}
+
+			if (m_buffer[2U] != MMDVM_ACK)
 				break;
 
-			case MMDVM_GET_STATUS: {
-					// if (m_trace)
-					//	CUtils::dump(1U, "GET_STATUS", m_buffer, m_length);
+			LogMessage("The MMDVM has been reset");
 
-					switch (m_protocolVersion) {
-					case 1U: {
-						m_mode = m_buffer[4U];
+			m_playoutTimer.start();
+			m_inactivityTimer.stop();
+			m_statusTimer.start();
 
-						m_tx = (m_buffer[5U] & 0x01U) == 0x01U;
+			m_recovery = MR_NONE;
+			m_error    = false;
+			return;
 
-						bool adcOverflow = (m_buffer[5U] & 0x02U) == 0x02U;
-						if (adcOverflow)
-							LogError("MMDVM ADC levels have overflowed");
+		default:
+			break;
+		}
+	}
 
-						bool rxOverflow = (m_buffer[5U] & 0x04U) == 0x04U;
-						if (rxOverflow)
-							LogError("MMDVM RX buffer has overflowed");
+	if (!m_recoveryTimer.hasExpired())
+		return;
 
-						bool txOverflow = (m_buffer[5U] & 0x08U) == 0x08U;
-						if (txOverflow)
-							LogError("MMDVM TX buffer has overflowed");
+	if (m_recovery == MR_WAIT_FREQ || m_recovery == MR_WAIT_CONFIG) {
+		LogError("The MMDVM is not responding to the %s command", m_recovery == MR_WAIT_FREQ ? "SET_FREQ" : "SET_CONFIG");
+		retryRecovery();
+		return;
+	}
 
-						bool dacOverflow = (m_buffer[5U] & 0x20U) == 0x20U;
-						if (dacOverflow)
-							LogError("MMDVM DAC levels have overflowed");
+	if (m_recoveryCount >= 6U) {
+		LogError("Unable to read the firmware version after six attempts");
+		retryRecovery();
+		return;
+	}
 
-						m_dmrSpace1  = m_buffer[7U];
-						m_dmrSpace2  = m_buffer[8U];
+	bool ret = writeVersion();
+	if (!ret) {
+		retryRecovery();
+		return;
+	}
 
-						if (m_length > 12U)
-							m_pocsagSpace = m_buffer[12U];
-						}
-						break;
-					case 2U: {
-						m_mode = m_buffer[3U];
+	m_recoveryCount++;
+	m_recoveryTimer.setTimeout(1U, 800U);
+	m_recoveryTimer.start();
+}
 
-						m_tx = (m_buffer[4U] & 0x01U) == 0x01U;
+void CModem::retryRecovery()
+{
+	m_serial->close();
 
-						bool adcOverflow = (m_buffer[4U] & 0x02U) == 0x02U;
-						if (adcOverflow)
-							LogError("MMDVM ADC levels have overflowed");
+	m_recovery = MR_WAIT_OPEN;
+	m_recoveryTimer.setTimeout(5U);
+	m_recoveryTimer.start();
+}
 
-						bool rxOverflow = (m_buffer[4U] & 0x04U) == 0x04U;
-						if (rxOverflow)
-							LogError("MMDVM RX buffer has overflowed");
+void CModem::gatherTX(CFrameQueue& queue, const char* text, bool timestamped, unsigned int& count, unsigned int& offset)
+{
+	assert(text != NULL);
+	assert(count < TX_BATCH_FRAMES);
+
+	unsigned int len = 0U;
+	const unsigned char* frame = queue.peek(len);
+	assert(frame != NULL);
+
+	m_txTimestamps[count] = 0ULL;
+	if (timestamped) {
+		::memcpy(&m_txTimestamps[count], frame, TIMESTAMP_LENGTH);
+		frame += TIMESTAMP_LENGTH;
+		len   -= TIMESTAMP_LENGTH;
+	}
 
-						bool txOverflow = (m_buffer[4U] & 0x08U) == 0x08U;
-						if (txOverflow)
-							LogError("MMDVM TX buffer has overflowed");
+	::memcpy(m_txBuffer + offset, frame, len);
+	queue.pop();
 
-						bool dacOverflow = (m_buffer[4U] & 0x20U) == 0x20U;
-						if (dacOverflow)
-							LogError("MMDVM DAC levels have overflowed");
+	if (m_trace)
+		CUtils::dump(1U, text, m_txBuffer + offset, len);
 
-						m_dmrSpace1   = m_buffer[7U];
-						m_dmrSpace2   = m_buffer[8U];
-						m_pocsagSpace = m_buffer[16U];
+	m_txIOV[count].iov_base = m_txBuffer + offset;
+	m_txIOV[count].iov_len  = len;
 
-						}
-						break;
-					default:
-						m_dmrSpace1   = 0U;
-						m_dmrSpace2   = 0U;
-						m_pocsagSpace = 0U;
-						break;
-					}
+	count++;
+	offset += len;
+}
 
-					m_inactivityTimer.start();
-					// LogMessage("status=%02X, tx=%d, space=%u,%u,%u,%u,%u,%u,%u cd=%d", m_buffer[5U], int(m_tx), m_dmrSpace1, m_dmrSpace2, m_pocsagSpace);
-				}
-				break;
+void CModem::processResponse()
+{
+	switch (m_buffer[2U]) {
+		case MMDVM_DMR_DATA1: {
+				if (m_trace)
+					CUtils::dump(1U, "RX DMR Data 1", m_buffer, m_length);
 
-			case MMDVM_TRANSPARENT: {
-					if (m_trace)
-						CUtils::dump(1U, "RX Transparent Data", m_buffer, m_length);
+				unsigned char* data = m_rxDMRData1.reserve(TIMESTAMP_LENGTH + m_length - 2U);
+				if (data == NULL)
+					break;
 
-					unsigned char offset = m_sendTransparentDataFrameType;
-					if (offset > 1U) offset = 1U;
-					unsigned char data = m_length - 3U + offset;
-					m_rxTransparentData.addData(&data, 1U);
+				::memcpy(data, &m_rxTimestamp, TIMESTAMP_LENGTH);
+				data += TIMESTAMP_LENGTH;
 
-					m_rxTransparentData.addData(m_buffer + 3U - offset, m_length - 3U + offset);
-				}
-				break;
+				if (m_buffer[3U] == (DMR_SYNC_DATA | DT_TERMINATOR_WITH_LC))
+					data[0U] = TAG_EOT;
+				else
+					data[0U] = TAG_DATA;
 
-			// These should not be received, but don't complain if we do
-			case MMDVM_GET_VERSION:
-			case MMDVM_ACK:
-				break;
+				::memcpy(data + 1U, m_buffer + 3U, m_length - 3U);
+				m_rxDMRData1.commit(TIMESTAMP_LENGTH + m_length - 2U);
+			}
+			break;
 
-			case MMDVM_NAK:
-				LogWarning("Received a NAK from the MMDVM, command = 0x%02X, reason = %u", m_buffer[3U], m_buffer[4U]);
-				break;
+		case MMDVM_DMR_DATA2: {
+				if (m_trace)
+					CUtils::dump(1U, "RX DMR Data 2", m_buffer, m_length);
 
-			case MMDVM_DEBUG1:
-			case MMDVM_DEBUG2:
-			case MMDVM_DEBUG3:
-			case MMDVM_DEBUG4:
-			case MMDVM_DEBUG5:
-				printDebug();
-				break;
+				unsigned char* data = m_rxDMRData2.reserve(TIMESTAMP_LENGTH + m_length - 2U);
+				if (data == NULL)
+					break;
 
-			case MMDVM_SERIAL:
-				//DMRHost does not process serial data from the display,
-				// so we send it to the transparent port if sendFrameType==1
-				if (m_sendTransparentDataFrameType > 0U) {
-					if (m_trace)
-						CUtils::dump(1U, "RX Serial Data", m_buffer, m_length);
+				::memcpy(data, &m_rxTimestamp, TIMESTAMP_LENGTH);
+				data += TIMESTAMP_LENGTH;
 
-					unsigned char offset = m_sendTransparentDataFrameType;
-					if (offset > 1U) offset = 1U;
-					unsigned char data = m_length - 3U + offset;
-					m_rxTransparentData.addData(&data, 1U);
+				if (m_buffer[3U] == (DMR_SYNC_DATA | DT_TERMINATOR_WITH_LC))
+					data[0U] = TAG_EOT;
+				else
+					data[0U] = TAG_DATA;
 
-					m_rxTransparentData.addData(m_buffer + 3U - offset, m_length - 3U + offset);
-					break; //only break when sendFrameType>0, else message is unknown
-				}
-			default:
-				LogMessage("Unknown message, type: %02X", m_buffer[2U]);
-				CUtils::dump("Buffer dump", m_buffer, m_length);
-				break;
-		}
-	}
+				::memcpy(data + 1U, m_buffer + 3U, m_length - 3U);
+				m_rxDMRData2.commit(TIMESTAMP_LENGTH + m_length - 2U);
+			}
+			break;
 
-	// Only feed data to the modem if the playout timer has expired
-	m_playoutTimer.clock(ms);
-	if (!m_playoutTimer.hasExpired())
-		return;
+		case MMDVM_DMR_LOST1: {
+				if (m_trace)
+					CUtils::dump(1U, "RX DMR Lost 1", m_buffer, m_length);
 
-	if (m_dmrSpace1 > 1U && !m_txDMRData1.isEmpty()) {
-		unsigned char len = 0U;
-		m_txDMRData1.getData(&len, 1U);
-		m_txDMRData1.getData(m_buffer, len);
+				unsigned char* data = m_rxDMRData1.reserve(TIMESTAMP_LENGTH + 1U);
+				if (data == NULL)
+					break;
 
-		if (m_trace)
-			CUtils::dump(1U, "TX DMR Data 1", m_buffer, len);
+				::memcpy(data, &m_rxTimestamp, TIMESTAMP_LENGTH);
+				data[TIMESTAMP_LENGTH] = TAG_LOST;
+				m_rxDMRData1.commit(TIMESTAMP_LENGTH + 1U);
+			}
+			break;
 
-		int ret = m_serial->write(m_buffer, len);
-		if (ret != int(len))
-			LogWarning("Error when writing DMR data to the MMDVM");
+		case MMDVM_DMR_LOST2: {
+				if (m_trace)
+					CUtils::dump(1U, "RX DMR Lost 2", m_buffer, m_length);
 
-		m_playoutTimer.start();
+				unsigned char* data = m_rxDMRData2.reserve(TIMESTAMP_LENGTH + 1U);
+				if (data == NULL)
+					break;
 
-		m_dmrSpace1--;
-	}
+				::memcpy(data, &m_rxTimestamp, TIMESTAMP_LENGTH);
+				data[TIMESTAMP_LENGTH] = TAG_LOST;
+				m_rxDMRData2.commit(TIMESTAMP_LENGTH + 1U);
+			}
+			break;
 
-	if (m_dmrSpace2 > 1U && !m_txDMRData2.isEmpty()) {
-		unsigned char len = 0U;
-		m_txDMRData2.getData(&len, 1U);
-		m_txDMRData2.getData(m_buffer, len);
+		case MMDVM_GET_STATUS: {
+				// if (m_trace)
+				//	CUtils::dump(1U, "GET_STATUS", m_buffer, m_length);
 
-		if (m_trace)
-			CUtils::dump(1U, "TX DMR Data 2", m_buffer, len);
+				switch (m_protocolVersion) {
+				case 1U: {
+					m_mode = m_buffer[4U];
 
-		int ret = m_serial->write(m_buffer, len);
-		if (ret != int(len))
-			LogWarning("Error when writing DMR data to the MMDVM");
+					m_tx = (m_buffer[5U] & 0x01U) == 0x01U;
 
-		m_playoutTimer.start();
+					bool adcOverflow = (m_buffer[5U] & 0x02U) == 0x02U;
+					if (adcOverflow)
+						LogError("MMDVM ADC levels have overflowed");
 
-		m_dmrSpace2--;
-	}
+					bool rxOverflow = (m_buffer[5U] & 0x04U) == 0x04U;
+					if (rxOverflow)
+						LogError("MMDVM RX buffer has overflowed");
 
-	if (m_pocsagSpace > 1U && !m_txPOCSAGData.isEmpty()) {
-		unsigned char len = 0U;
-		m_txPOCSAGData.getData(&len, 1U);
-		m_txPOCSAGData.getData(m_buffer, len);
+					bool txOverflow = (m_buffer[5U] & 0x08U) == 0x08U;
+					if (txOverflow)
+						LogError("MMDVM TX buffer has overflowed");
 
-		if (m_trace)
-			CUtils::dump(1U, "TX POCSAG Data", m_buffer, len);
+					bool dacOverflow = (m_buffer[5U] & 0x20U) == 0x20U;
+					if (dacOverflow)
+						LogError("MMDVM DAC levels have overflowed");
 
-		int ret = m_serial->write(m_buffer, len);
-		if (ret != int(len))
-			LogWarning("Error when writing POCSAG data to the MMDVM");
+					m_dmrSpace1  = m_buffer[7U];
+					m_dmrSpace2  = m_buffer[8U];
 
-		m_playoutTimer.start();
+					if (m_length > 12U)
+						m_pocsagSpace = m_buffer[12U];
+					}
+					break;
+				case 2U: {
+					m_mode = m_buffer[3U];
 
-		m_pocsagSpace--;
-	}
+					m_tx = (m_buffer[4U] & 0x01U) == 0x01U;
 
-	if (!m_txTransparentData.isEmpty()) {
-		unsigned char len = 0U;
-		m_txTransparentData.getData(&len, 1U);
-		m_txTransparentData.getData(m_buffer, len);
+					bool adcOverflow = (m_buffer[4U] & 0x02U) == 0x02U;
+					if (adcOverflow)
+						LogError("MMDVM ADC levels have overflowed");
 
-		if (m_trace)
-			CUtils::dump(1U, "TX Transparent Data", m_buffer, len);
+					bool rxOverflow = (m_buffer[4U] & 0x04U) == 0x04U;
+					if (rxOverflow)
+						LogError("MMDVM RX buffer has overflowed");
 
-		int ret = m_serial->write(m_buffer, len);
-		if (ret != int(len))
-			LogWarning("Error when writing Transparent data to the MMDVM");
+					bool txOverflow = (m_buffer[4U] & 0x08U) == 0x08U;
+					if (txOverflow)
+						LogError("MMDVM TX buffer has overflowed");
+
+					bool dacOverflow = (m_buffer[4U] & 0x20U) == 0x20U;
+					if (dacOverflow)
+						LogError("MMDVM DAC levels have overflowed");
+
+					m_dmrSpace1   = m_buffer[7U];
+					m_dmrSpace2   = m_buffer[8U];
+					m_pocsagSpace = m_buffer[16U];
+
+					}
+					break;
+				default:
+					m_dmrSpace1   = 0U;
+					m_dmrSpace2   = 0U;
+					m_pocsagSpace = 0U;
+					break;
+				}
+
+				m_inactivityTimer.start();
+				// LogMessage("status=%02X, tx=%d, space=%u,%u,%u,%u,%u,%u,%u cd=%d", m_buffer[5U], int(m_tx), m_dmrSpace1, m_dmrSpace2, m_pocsagSpace);
+			}
+			break;
+
+		case MMDVM_TRANSPARENT: {
+				if (m_trace)
+					CUtils::dump(1U, "RX Transparent Data", m_buffer, m_length);
+
+				unsigned char offset = m_sendTransparentDataFrameType;
+				if (offset > 1U) offset = 1U;
+				m_rxTransparentData.addData(m_buffer + 3U - offset, m_length - 3U + offset);
+			}
+			break;
+
+		// These should not be received, but don't complain if we do
+		case MMDVM_GET_VERSION:
+		case MMDVM_ACK:
+			break;
+
+		case MMDVM_NAK:
+			LogWarning("Received a NAK from the MMDVM, command = 0x%02X, reason = %u", m_buffer[3U], m_buffer[4U]);
+			break;
+
+		case MMDVM_DEBUG1:
+		case MMDVM_DEBUG2:
+		case MMDVM_DEBUG3:
+		case MMDVM_DEBUG4:
+		case MMDVM_DEBUG5:
+			printDebug();
+			break;
+
+		case MMDVM_SERIAL:
+			//DMRHost does not process serial data from the display,
+			// so we send it to the transparent port if sendFrameType==1
+			if (m_sendTransparentDataFrameType > 0U) {
+				if (m_trace)
+					CUtils::dump(1U, "RX Serial Data", m_buffer, m_length);
+
+				unsigned char offset = m_sendTransparentDataFrameType;
+				if (offset > 1U) offset = 1U;
+				m_rxTransparentData.addData(m_buffer + 3U - offset, m_length - 3U + offset);
+				break; //only break when sendFrameType>0, else message is unknown
+			}
+		default:
+			LogMessage("Unknown message, type: %02X", m_buffer[2U]);
+			CUtils::dump("Buffer dump", m_buffer, m_length);
+			break;
 	}
 }
 
+int CModem::getFd() const
+{
+	// With the I/O thread running the host is woken when frames have been received
+	if (m_running)
+		return m_rxNotify[0U];
+
+	if (m_serial == NULL)
+		return -1;
+
+	return m_serial->getFd();
+}
+
+unsigned int CModem::getTimeout()
+{
+	// The I/O thread keeps its own timers
+	if (m_running)
+		return 0xFFFFFFFFU;
+
+	return getTimeoutInt();
+}
+
+unsigned int CModem::getTimeoutInt()
+{
+	if (m_recovery != MR_NONE)
+		return m_recoveryTimer.getRemainingMS();
+
+	// Frames already read from the port don't need the port to wake us
+	if (hasResponse())
+		return 0U;
+
+	// Queued frames only have to wait for the playout timer
+	if ((m_dmrSpace1 > 1U && !m_txDMRData1.isEmpty()) ||
+	    (m_dmrSpace2 > 1U && !m_txDMRData2.isEmpty()) ||
+	    (m_pocsagSpace > 1U && !m_txPOCSAGData.isEmpty()) ||
+	    !m_txTransparentData.isEmpty())
+		return m_playoutTimer.getRemainingMS();
+
+	return m_statusTimer.getRemainingMS();
+}
+
 void CModem::close()
+{
+	stopThread();
+
+	closeInt();
+
+	m_rxDMRData1.logStats();
+	m_rxDMRData2.logStats();
+	m_txDMRData1.logStats();
+	m_txDMRData2.logStats();
+	m_txPOCSAGData.logStats();
+
+	m_netLatency.logStats("DMR, network to modem");
+}
+
+void CModem::closeInt()
 {
 	assert(m_serial != NULL);
 
 	::LogMessage("Closing the MMDVM");
 
-	m_serial->close();
+	// The port is already closed while waiting to reopen it
+	if (m_recovery != MR_WAIT_OPEN)
+		m_serial->close();
+
+	m_recovery = MR_NONE;
 }
 
-unsigned int CModem::readDMRData1(unsigned char* data)
+bool CModem::startThread()
 {
-	assert(data != NULL);
+	if (::pipe(m_rxNotify) < 0 || ::pipe(m_txNotify) < 0) {
+		LogError("Cannot create the modem I/O thread pipes, errno=%d", errno);
+		return false;
+	}
 
-	if (m_rxDMRData1.isEmpty())
-		return 0U;
+	for (unsigned int i = 0U; i < 2U; i++) {
+		::fcntl(m_rxNotify[i], F_SETFL, O_NONBLOCK);
+		::fcntl(m_txNotify[i], F_SETFL, O_NONBLOCK);
+	}
 
-	unsigned char len = 0U;
-	m_rxDMRData1.getData(&len, 1U);
-	m_rxDMRData1.getData(data, len);
+	m_running = true;
+	m_thread  = std::thread(&CModem::threadMain, this);
 
-	return len;
+	LogMessage("Started the modem I/O thread");
+
+	return true;
 }
 
-unsigned int CModem::readDMRData2(unsigned char* data)
+void CModem::stopThread()
 {
-	assert(data != NULL);
+	if (!m_running)
+		return;
 
-	if (m_rxDMRData2.isEmpty())
-		return 0U;
+	m_running = false;
+	wakeThread();
+
+	m_thread.join();
 
-	unsigned char len = 0U;
-	m_rxDMRData2.getData(&len, 1U);
-	m_rxDMRData2.getData(data, len);
+	for (unsigned int i = 0U; i < 2U; i++) {
+		::close(m_rxNotify[i]);
+		::close(m_txNotify[i]);
+		m_rxNotify[i] = m_txNotify[i] = -1;
+	}
 
-	return len;
+	LogMessage("Stopped the modem I/O thread");
 }
 
-unsigned int CModem::readTransparentData(unsigned char* data)
+void CModem::wakeThread()
+{
+	if (m_txNotify[1U] < 0)
+		return;
+
+	unsigned char c = 0x00U;
+	ssize_t n = ::write(m_txNotify[1U], &c, 1U);
+	(void)n;
+}
+
+void CModem::threadMain()
+{
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	while (m_running) {
+		pollfd pfd[2U];
+		pfd[0U].fd      = m_serial->getFd();
+		pfd[0U].events  = POLLIN;
+		pfd[0U].revents = 0;
+		pfd[1U].fd      = m_txNotify[0U];
+		pfd[1U].events  = POLLIN;
+		pfd[1U].revents = 0;
+
+		::poll(pfd, 2U, int(getTimeoutInt()));
+
+		if ((pfd[1U].revents & POLLIN) == POLLIN) {
+			unsigned char buffer[50U];
+			while (::read(m_txNotify[0U], buffer, 50U) > 0)
+				;
+		}
+
+		if (!m_running)
+			break;
+
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+		m_rxFrames += clockInt(ms);
+
+		if (!m_rxDMRData1.isEmpty() || !m_rxDMRData2.isEmpty() || !m_rxTransparentData.isEmpty()) {
+			unsigned char c = 0x00U;
+			ssize_t n = ::write(m_rxNotify[1U], &c, 1U);
+			(void)n;
+		}
+	}
+}
+
+bool CModem::writeCommand(const unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+	assert(length > 0U && length < 256U);
+
+	if (!m_running) {
+		if (m_recovery != MR_NONE)
+			return false;
+
+		return m_serial->write(buffer, length) == int(length);
+	}
+
+	bool ret = m_txCommand.addData(buffer, length);
+
+	wakeThread();
+
+	return ret;
+}
+
+unsigned int CModem::readDMRData1(unsigned char* data, unsigned long long& timestamp)
 {
 	assert(data != NULL);
 
-	if (m_rxTransparentData.isEmpty())
+	return readTimestamped(m_rxDMRData1, data, timestamp);
+}
+
+unsigned int CModem::readDMRData2(unsigned char* data, unsigned long long& timestamp)
+{
+	assert(data != NULL);
+
+	return readTimestamped(m_rxDMRData2, data, timestamp);
+}
+
+unsigned int CModem::readTimestamped(CFrameQueue& queue, unsigned char* data, unsigned long long& timestamp)
+{
+	unsigned int length = 0U;
+	const unsigned char* frame = queue.peek(length);
+	if (frame == NULL)
 		return 0U;
 
-	unsigned char len = 0U;
-	m_rxTransparentData.getData(&len, 1U);
-	m_rxTransparentData.getData(data, len);
+	::memcpy(&timestamp, frame, TIMESTAMP_LENGTH);
+
+	length -= TIMESTAMP_LENGTH;
+	::memcpy(data, frame + TIMESTAMP_LENGTH, length);
+
+	queue.pop();
+
+	return length;
+}
+
+unsigned int CModem::readTransparentData(unsigned char* data)
+{
+	assert(data != NULL);
 
-	return len;
+	return m_rxTransparentData.getData(data);
 }
 
 bool CModem::hasDMRSpace1() const
 {
-	unsigned int space = m_txDMRData1.freeSpace() / (DMR_FRAME_LENGTH_BYTES + 4U);
+	unsigned int space = m_txDMRData1.freeSpace() / (TIMESTAMP_LENGTH + DMR_FRAME_LENGTH_BYTES + 4U);
 
 	return space > 1U;
 }
 
 bool CModem::hasDMRSpace2() const
 {
-	unsigned int space = m_txDMRData2.freeSpace() / (DMR_FRAME_LENGTH_BYTES + 4U);
+	unsigned int space = m_txDMRData2.freeSpace() / (TIMESTAMP_LENGTH + DMR_FRAME_LENGTH_BYTES + 4U);
 
 	return space > 1U;
 }
 
-bool CModem::writeDMRData1(const unsigned char* data, unsigned int length)
+bool CModem::writeDMRData1(const unsigned char* data, unsigned int length, unsigned long long timestamp)
 {
 	assert(data != NULL);
 	assert(length > 0U);
@@ -581,7 +1010,12 @@ bool CModem::writeDMRData1(const unsigned char* data, unsigned int length)
 	if (data[0U] != TAG_DATA && data[0U] != TAG_EOT)
 		return false;
 
-	unsigned char buffer[40U];
+	unsigned char* buffer = m_txDMRData1.reserve(TIMESTAMP_LENGTH + length + 2U);
+	if (buffer == NULL)
+		return false;
+
+	::memcpy(buffer, &timestamp, TIMESTAMP_LENGTH);
+	buffer += TIMESTAMP_LENGTH;
 
 	buffer[0U] = MMDVM_FRAME_START;
 	buffer[1U] = length + 2U;
@@ -589,14 +1023,14 @@ bool CModem::writeDMRData1(const unsigned char* data, unsigned int length)
 
 	::memcpy(buffer + 3U, data + 1U, length - 1U);
 
-	unsigned char len = length + 2U;
-	m_txDMRData1.addData(&len, 1U);
-	m_txDMRData1.addData(buffer, len);
+	m_txDMRData1.commit(TIMESTAMP_LENGTH + length + 2U);
+
+	wakeThread();
 
 	return true;
 }
 
-bool CModem::writeDMRData2(const unsigned char* data, unsigned int length)
+bool CModem::writeDMRData2(const unsigned char* data, unsigned int length, unsigned long long timestamp)
 {
 	assert(data != NULL);
 	assert(length > 0U);
@@ -604,7 +1038,12 @@ bool CModem::writeDMRData2(const unsigned char* data, unsigned int length)
 	if (data[0U] != TAG_DATA && data[0U] != TAG_EOT)
 		return false;
 
-	unsigned char buffer[40U];
+	unsigned char* buffer = m_txDMRData2.reserve(TIMESTAMP_LENGTH + length + 2U);
+	if (buffer == NULL)
+		return false;
+
+	::memcpy(buffer, &timestamp, TIMESTAMP_LENGTH);
+	buffer += TIMESTAMP_LENGTH;
 
 	buffer[0U] = MMDVM_FRAME_START;
 	buffer[1U] = length + 2U;
@@ -612,9 +1051,9 @@ bool CModem::writeDMRData2(const unsigned char* data, unsigned int length)
 
 	::memcpy(buffer + 3U, data + 1U, length - 1U);
 
-	unsigned char len = length + 2U;
-	m_txDMRData2.addData(&len, 1U);
-	m_txDMRData2.addData(buffer, len);
+	m_txDMRData2.commit(TIMESTAMP_LENGTH + length + 2U);
+
+	wakeThread();
 
 	return true;
 }
@@ -631,7 +1070,9 @@ bool CModem::writePOCSAGData(const unsigned char* data, unsigned int length)
 	assert(data != NULL);
 	assert(length > 0U);
 
-	unsigned char buffer[130U];
+	unsigned char* buffer = m_txPOCSAGData.reserve(length + 3U);
+	if (buffer == NULL)
+		return false;
 
 	buffer[0U] = MMDVM_FRAME_START;
 	buffer[1U] = length + 3U;
@@ -639,9 +1080,9 @@ bool CModem::writePOCSAGData(const unsigned char* data, unsigned int length)
 
 	::memcpy(buffer + 3U, data, length);
 
-	unsigned char len = length + 3U;
-	m_txPOCSAGData.addData(&len, 1U);
-	m_txPOCSAGData.addData(buffer, len);
+	m_txPOCSAGData.commit(length + 3U);
+
+	wakeThread();
 
 	return true;
 }
@@ -673,11 +1114,11 @@ bool CModem::writeTransparentData(const unsigned char* data, unsigned int length
 		::memcpy(buffer + 3U, data, length);
 	}
 
-	unsigned char len = length + 3U;
-	m_txTransparentData.addData(&len, 1U);
-	m_txTransparentData.addData(buffer, len);
+	bool ret = m_txTransparentData.addData(buffer, length + 3U);
 
-	return true;
+	wakeThread();
+
+	return ret;
 }
 
 bool CModem::hasTX() const
@@ -707,83 +1148,15 @@ bool CModem::readVersion()
 	usleep(2000 * 1000);	// 2s
 
 	for (unsigned int i = 0U; i < 6U; i++) {
-		unsigned char buffer[3U];
-
-		buffer[0U] = MMDVM_FRAME_START;
-		buffer[1U] = 3U;
-		buffer[2U] = MMDVM_GET_VERSION;
-
-		// CUtils::dump(1U, "Written", buffer, 3U);
-
-		int ret = m_serial->write(buffer, 3U);
-		if (ret != 3)
+		bool ret = writeVersion();
+		if (!ret)
 			return false;
 
 		for (unsigned int count = 0U; count < MAX_RESPONSES; count++) {
 			usleep(10 * 1000);
 			RESP_TYPE_MMDVM resp = getResponse();
-			if (resp == RTM_OK && m_buffer[2U] == MMDVM_GET_VERSION) {
-				m_protocolVersion = m_buffer[3U];
-				switch (m_protocolVersion) {
-				case 1U:
-					LogInfo("MMDVM protocol version: %u, description: %.*s", m_protocolVersion, m_length - 4U, m_buffer + 4U);
-					m_capabilities1 = CAP1_DMR;
-					m_capabilities2 = CAP2_POCSAG;
-					break;
-				case 2U:
-					LogInfo("MMDVM protocol version: %u, description: %.*s", m_protocolVersion, m_length - 23U, m_buffer + 23U);
-					switch (m_buffer[6U]) {
-					case 0U:
-						LogInfo("CPU: Atmel ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U], m_buffer[19U], m_buffer[20U], m_buffer[21U], m_buffer[22U]);
-						break;
-					case 1U:
-						LogInfo("CPU: NXP ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U], m_buffer[19U], m_buffer[20U], m_buffer[21U], m_buffer[22U]);
-						break;
-					case 2U:
-						LogInfo("CPU: ST-Micro ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U]);
-						break;
-					default:
-						LogInfo("CPU: Unknown type: %u", m_buffer[6U]);
-						break;
-					}
-					m_capabilities1 = m_buffer[4U];
-					m_capabilities2 = m_buffer[5U];
-					char modeText[100U];
-					::strcpy(modeText, "Modes:");
-					if (hasDMR())
-						::strcat(modeText, " DMR");
-					if (hasPOCSAG())
-						::strcat(modeText, " POCSAG");
-					LogInfo(modeText);
-					break;
-				default:
-					LogError("MMDVM protocol version: %u, unsupported by this version of the MMDVM Host", m_protocolVersion);
-					return false;
-				}
-
-				char _hwType[40U];
-				::strcpy(_hwType, "MMDVM_Unknown");
-
-				if (::memcmp(m_buffer + 4U, "MMDVM ", 6U) == 0)
-					::strcpy(_hwType, "MMDVM");
-				else if (::memcmp(m_buffer + 4U, "DVMEGA ", 7U) == 0)
-					::strcpy(_hwType, "MMDVM_DVMega");
-				else {
-					char* hw = NULL;
-					if (m_protocolVersion == 1)
-						hw = ::strtok((char*)m_buffer + 4U, "-");
-					if (m_protocolVersion == 2)
-						hw = ::strtok((char*)m_buffer + 23U, "-");
-					// we do not trust the modem fw too much
-					if (hw != NULL) {
-						::strcpy(_hwType, "MMDVM_");
-						::strncat(_hwType, hw, 40U - 6U);
-					}
-				}
-				m_hwType = strdup(_hwType);
-
-				return true;
-			}
+			if (resp == RTM_OK && m_buffer[2U] == MMDVM_GET_VERSION)
+				return processVersion();
 		}
 
 		usleep(1500 * 1000);
@@ -794,6 +1167,85 @@ bool CModem::readVersion()
 	return false;
 }
 
+bool CModem::writeVersion()
+{
+	assert(m_serial != NULL);
+
+	unsigned char buffer[3U];
+
+	buffer[0U] = MMDVM_FRAME_START;
+	buffer[1U] = 3U;
+	buffer[2U] = MMDVM_GET_VERSION;
+
+	// CUtils::dump(1U, "Written", buffer, 3U);
+
+	return m_serial->write(buffer, 3U) == 3;
+}
+
+bool CModem::processVersion()
+{
+	m_protocolVersion = m_buffer[3U];
+	switch (m_protocolVersion) {
+	case 1U:
+		LogInfo("MMDVM protocol version: %u, description: %.*s", m_protocolVersion, m_length - 4U, m_buffer + 4U);
+		m_capabilities1 = CAP1_DMR;
+		m_capabilities2 = CAP2_POCSAG;
+		break;
+	case 2U:
+		LogInfo("MMDVM protocol version: %u, description: %.*s", m_protocolVersion, m_length - 23U, m_buffer + 23U);
+		switch (m_buffer[6U]) {
+		case 0U:
+			LogInfo("CPU: Atmel ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U], m_buffer[19U], m_buffer[20U], m_buffer[21U], m_buffer[22U]);
+			break;
+		case 1U:
+			LogInfo("CPU: NXP ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U], m_buffer[19U], m_buffer[20U], m_buffer[21U], m_buffer[22U]);
+			break;
+		case 2U:
+			LogInfo("CPU: ST-Micro ARM, UDID: %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X", m_buffer[7U], m_buffer[8U], m_buffer[9U], m_buffer[10U], m_buffer[11U], m_buffer[12U], m_buffer[13U], m_buffer[14U], m_buffer[15U], m_buffer[16U], m_buffer[17U], m_buffer[18U]);
+			break;
+		default:
+			LogInfo("CPU: Unknown type: %u", m_buffer[6U]);
+			break;
+		}
+		m_capabilities1 = m_buffer[4U];
+		m_capabilities2 = m_buffer[5U];
+		char modeText[100U];
+		::strcpy(modeText, "Modes:");
+		if (hasDMR())
+			::strcat(modeText, " DMR");
+		if (hasPOCSAG())
+			::strcat(modeText, " POCSAG");
+		LogInfo(modeText);
+		break;
+	default:
+		LogError("MMDVM protocol version: %u, unsupported by this version of the MMDVM Host", m_protocolVersion);
+		return false;
+	}
+
+	char _hwType[40U];
+	::strcpy(_hwType, "MMDVM_Unknown");
+
+	if (::memcmp(m_buffer + 4U, "MMDVM ", 6U) == 0)
+		::strcpy(_hwType, "MMDVM");
+	else if (::memcmp(m_buffer + 4U, "DVMEGA ", 7U) == 0)
+		::strcpy(_hwType, "MMDVM_DVMega");
+	else {
+		char* hw = NULL;
+		if (m_protocolVersion == 1)
+			hw = ::strtok((char*)m_buffer + 4U, "-");
+		if (m_protocolVersion == 2)
+			hw = ::strtok((char*)m_buffer + 23U, "-");
+		// we do not trust the modem fw too much
+		if (hw != NULL) {
+			::strcpy(_hwType, "MMDVM_");
+			::strncat(_hwType, hw, 40U - 6U);
+		}
+	}
+	m_hwType = strdup(_hwType);
+
+	return true;
+}
+
 bool CModem::readStatus()
 {
 	assert(m_serial != NULL);
@@ -810,18 +1262,31 @@ bool CModem::readStatus()
 }
 
 bool CModem::writeConfig()
+{
+	if (!sendConfig())
+		return false;
+
+	if (!waitForAck("SET_CONFIG"))
+		return false;
+
+	m_playoutTimer.start();
+
+	return true;
+}
+
+bool CModem::sendConfig()
 {
 	switch (m_protocolVersion) {
 	case 1U:
-		return setConfig1();
+		return sendConfig1();
 	case 2U:
-		return setConfig2();
+		return sendConfig2();
 	default:
 		return false;
 	}
 }
 
-bool CModem::setConfig1()
+bool CModem::sendConfig1()
 {
 	assert(m_serial != NULL);
 
@@ -888,38 +1353,10 @@ bool CModem::setConfig1()
 
 	// CUtils::dump(1U, "Written", buffer, 26U);
 
-	int ret = m_serial->write(buffer, 26U);
-	if (ret != 26)
-		return false;
-
-	unsigned int count = 0U;
-	RESP_TYPE_MMDVM resp;
-	do {
-		usleep(10 * 1000);
-
-		resp = getResponse();
-		if (resp == RTM_OK && m_buffer[2U] != MMDVM_ACK && m_buffer[2U] != MMDVM_NAK) {
-			count++;
-			if (count >= MAX_RESPONSES) {
-				LogError("The MMDVM is not responding to the SET_CONFIG command");
-				return false;
-			}
-		}
-	} while (resp == RTM_OK && m_buffer[2U] != MMDVM_ACK && m_buffer[2U] != MMDVM_NAK);
-
-	// CUtils::dump(1U, "Response", m_buffer, m_length);
-
-	if (resp == RTM_OK && m_buffer[2U] == MMDVM_NAK) {
-		LogError("Received a NAK to the SET_CONFIG command from the modem");
-		return false;
-	}
-
-	m_playoutTimer.start();
-
-	return true;
+	return m_serial->write(buffer, 26U) == 26;
 }
 
-bool CModem::setConfig2()
+bool CModem::sendConfig2()
 {
 	assert(m_serial != NULL);
 
@@ -996,38 +1433,18 @@ bool CModem::setConfig2()
 
 	// CUtils::dump(1U, "Written", buffer, 40U);
 
-	int ret = m_serial->write(buffer, 40U);
-	if (ret != 40)
-		return false;
-
-	unsigned int count = 0U;
-	RESP_TYPE_MMDVM resp;
-	do {
-		usleep(10 * 1000);
-
-		resp = getResponse();
-		if (resp == RTM_OK && m_buffer[2U] != MMDVM_ACK && m_buffer[2U] != MMDVM_NAK) {
-			count++;
-			if (count >= MAX_RESPONSES) {
-				LogError("The MMDVM is not responding to the SET_CONFIG command");
-				return false;
-			}
-		}
-	} while (resp == RTM_OK && m_buffer[2U] != MMDVM_ACK && m_buffer[2U] != MMDVM_NAK);
-
-	// CUtils::dump(1U, "Response", m_buffer, m_length);
+	return m_serial->write(buffer, 40U) == 40;
+}
 
-	if (resp == RTM_OK && m_buffer[2U] == MMDVM_NAK) {
-		LogError("Received a NAK to the SET_CONFIG command from the modem");
+bool CModem::setFrequency()
+{
+	if (!sendFrequency())
 		return false;
-	}
-
-	m_playoutTimer.start();
 
-	return true;
+	return waitForAck("SET_FREQ");
 }
 
-bool CModem::setFrequency()
+bool CModem::sendFrequency()
 {
 	assert(m_serial != NULL);
 
@@ -1071,9 +1488,12 @@ bool CModem::setFrequency()
 
 	// CUtils::dump(1U, "Written", buffer, len);
 
-	int ret = m_serial->write(buffer, len);
-	if (ret != len)
-		return false;
+	return m_serial->write(buffer, len) == int(len);
+}
+
+bool CModem::waitForAck(const char* command)
+{
+	assert(command != NULL);
 
 	unsigned int count = 0U;
 	RESP_TYPE_MMDVM resp;
@@ -1084,7 +1504,7 @@ bool CModem::setFrequency()
 		if (resp == RTM_OK && m_buffer[2U] != MMDVM_ACK && m_buffer[2U] != MMDVM_NAK) {
 			count++;
 			if (count >= MAX_RESPONSES) {
-				LogError("The MMDVM is not responding to the SET_FREQ command");
+				LogError("The MMDVM is not responding to the %s command", command);
 				return false;
 			}
 		}
@@ -1093,7 +1513,7 @@ bool CModem::setFrequency()
 	// CUtils::dump(1U, "Response", m_buffer, m_length);
 
 	if (resp == RTM_OK && m_buffer[2U] == MMDVM_NAK) {
-		LogError("Received a NAK to the SET_FREQ command from the modem");
+		LogError("Received a NAK to the %s command from the modem", command);
 		return false;
 	}
 
@@ -1104,98 +1524,104 @@ RESP_TYPE_MMDVM CModem::getResponse()
 {
 	assert(m_serial != NULL);
 
-	if (m_offset == 0U) {
-		// Get the start of the frame or nothing at all
-		int ret = m_serial->read(m_buffer + 0U, 1U);
-		if (ret < 0) {
-			LogError("Error when reading from the modem");
-			return RTM_ERROR;
+	bool canRead = true;
+
+	for (;;) {
+		// Throw away anything that isn't the start of a frame
+		unsigned int start = 0U;
+		while (start < m_rxLength && m_rxBuffer[start] != MMDVM_FRAME_START)
+			start++;
+
+		if (start > 0U) {
+			m_rxLength -= start;
+			::memmove(m_rxBuffer, m_rxBuffer + start, m_rxLength);
 		}
 
-		if (ret == 0)
-			return RTM_TIMEOUT;
+		if (m_rxLength >= 2U) {
+			unsigned int length = m_rxBuffer[1U];
+			if (length >= 250U) {
+				LogError("Invalid length received from the modem - %u", length);
+				m_rxLength -= 1U;
+				::memmove(m_rxBuffer, m_rxBuffer + 1U, m_rxLength);
+				return RTM_ERROR;
+			}
 
-		if (m_buffer[0U] != MMDVM_FRAME_START)
-			return RTM_TIMEOUT;
+			// Use later two byte length field
+			if (length == 0U && m_rxLength >= 5U) {
+				length = (m_rxBuffer[3U] << 8) | m_rxBuffer[4U];
+				if (length < 5U || length > BUFFER_LENGTH) {
+					LogError("Invalid length received from the modem - %u", length);
+					m_rxLength -= 1U;
+					::memmove(m_rxBuffer, m_rxBuffer + 1U, m_rxLength);
+					return RTM_ERROR;
+				}
+			}
 
-		m_offset = 1U;
-	}
+			if (length > 0U && length < 3U) {
+				LogError("Invalid length received from the modem - %u", length);
+				m_rxLength -= 1U;
+				::memmove(m_rxBuffer, m_rxBuffer + 1U, m_rxLength);
+				return RTM_ERROR;
+			}
 
-	if (m_offset == 1U) {
-		// Get the length of the frame
-		int ret = m_serial->read(m_buffer + 1U, 1U);
-		if (ret < 0) {
-			LogError("Error when reading from the modem");
-			m_offset = 0U;
-			return RTM_ERROR;
-		}
+			if (length > 0U && m_rxLength >= length) {
+				::memcpy(m_buffer, m_rxBuffer, length);
+				m_length = length;
 
-		if (ret == 0)
-			return RTM_TIMEOUT;
+				m_rxLength -= length;
+				::memmove(m_rxBuffer, m_rxBuffer + length, m_rxLength);
 
-		if (m_buffer[1U] >= 250U) {
-			LogError("Invalid length received from the modem - %u", m_buffer[1U]);
-			m_offset = 0U;
-			return RTM_ERROR;
+				// CUtils::dump(1U, "Received", m_buffer, m_length);
+
+				return RTM_OK;
+			}
 		}
 
-		m_length = m_buffer[1U];
-		m_offset = 2U;
-	}
+		// Only read again when the last read added to a frame that is still incomplete
+		if (!canRead)
+			return RTM_TIMEOUT;
 
-	if (m_offset == 2U) {
-		// Get the frame type
-		int ret = m_serial->read(m_buffer + 2U, 1U);
+		// Take everything the port has in one go, it never blocks
+		int ret = m_serial->readAvailable(m_rxBuffer + m_rxLength, BUFFER_LENGTH - m_rxLength);
 		if (ret < 0) {
 			LogError("Error when reading from the modem");
-			m_offset = 0U;
+			m_rxLength = 0U;
 			return RTM_ERROR;
 		}
 
 		if (ret == 0)
 			return RTM_TIMEOUT;
 
-		m_offset = 3U;
-	}
-
-	if (m_offset >= 3U) {
-		// Use later two byte length field
-		if (m_length == 0U) {
-			int ret = m_serial->read(m_buffer + 3U, 2U);
-			if (ret < 0) {
-				LogError("Error when reading from the modem");
-				m_offset = 0U;
-				return RTM_ERROR;
-			}
+		// Frames completed by this read are stamped with its time for the RF to network trace
+		m_rxTimestamp = CLatencyStats::now();
 
-			if (ret == 0)
-				return RTM_TIMEOUT;
+		m_rxLength += ret;
 
-			m_length = (m_buffer[3U] << 8) | m_buffer[4U];
-			m_offset = 5U;
-		}
+		canRead = m_rxBuffer[0U] == MMDVM_FRAME_START;
+	}
+}
 
-		while (m_offset < m_length) {
-			int ret = m_serial->read(m_buffer + m_offset, m_length - m_offset);
-			if (ret < 0) {
-				LogError("Error when reading from the modem");
-				m_offset = 0U;
-				return RTM_ERROR;
-			}
+bool CModem::hasResponse() const
+{
+	if (m_rxLength == 0U)
+		return false;
 
-			if (ret == 0)
-				return RTM_TIMEOUT;
+	// Junk to discard is work too
+	if (m_rxBuffer[0U] != MMDVM_FRAME_START)
+		return true;
 
-			if (ret > 0)
-				m_offset += ret;
-		}
-	}
+	if (m_rxLength < 2U)
+		return false;
 
-	m_offset = 0U;
+	unsigned int length = m_rxBuffer[1U];
+	if (length == 0U) {
+		if (m_rxLength < 5U)
+			return false;
 
-	// CUtils::dump(1U, "Received", m_buffer, m_length);
+		length = (m_rxBuffer[3U] << 8) | m_rxBuffer[4U];
+	}
 
-	return RTM_OK;
+	return m_rxLength >= length;
 }
 
 const char* CModem::getHWType() const
@@ -1216,7 +1642,7 @@ bool CModem::setMode(unsigned char mode)
 
 	// CUtils::dump(1U, "Written", buffer, 4U);
 
-	return m_serial->write(buffer, 4U) == 4;
+	return writeCommand(buffer, 4U);
 }
 
 bool CModem::sendCWId(const std::string& callsign)
@@ -1238,7 +1664,7 @@ bool CModem::sendCWId(const std::string& callsign)
 
 	// CUtils::dump(1U, "Written", buffer, length + 3U);
 
-	return m_serial->write(buffer, length + 3U) == int(length + 3U);
+	return writeCommand(buffer, length + 3U);
 }
 
 bool CModem::writeDMRStart(bool tx)
@@ -1259,19 +1685,14 @@ bool CModem::writeDMRStart(bool tx)
 
 	// CUtils::dump(1U, "Written", buffer, 4U);
 
-	return m_serial->write(buffer, 4U) == 4;
+	return writeCommand(buffer, 4U);
 }
 
 bool CModem::writeDMRAbort(unsigned int slotNo)
 {
 	assert(m_serial != NULL);
 
-	if (slotNo == 1U)
-		m_txDMRData1.clear();
-	else
-		m_txDMRData2.clear();
-
-	unsigned char buffer[4U];
+	unsigned char buffer[4U + sizeof(unsigned int)];
 
 	buffer[0U] = MMDVM_FRAME_START;
 	buffer[1U] = 4U;
@@ -1280,7 +1701,21 @@ bool CModem::writeDMRAbort(unsigned int slotNo)
 
 	// CUtils::dump(1U, "Written", buffer, 4U);
 
-	return m_serial->write(buffer, 4U) == 4;
+	if (!m_running) {
+		if (slotNo == 1U)
+			m_txDMRData1.clear();
+		else
+			m_txDMRData2.clear();
+
+		return writeCommand(buffer, 4U);
+	}
+
+	// The I/O thread flushes the queue when it sends the abort, but only up to here, frames the host
+	// queues after the abort are kept
+	unsigned int mark = slotNo == 1U ? m_txDMRData1.getMark() : m_txDMRData2.getMark();
+	::memcpy(buffer + 4U, &mark, sizeof(mark));
+
+	return writeCommand(buffer, 4U + sizeof(unsigned int));
 }
 
 bool CModem::writeDMRShortLC(const unsigned char* lc)
@@ -1305,7 +1740,7 @@ bool CModem::writeDMRShortLC(const unsigned char* lc)
 
 	// CUtils::dump(1U, "Written", buffer, 12U);
 
-	return m_serial->write(buffer, 12U) == 12;
+	return writeCommand(buffer, 12U);
 }
 
 void CModem::printDebug()
@@ -19,11 +19,14 @@
 #pragma once
 
 #include "SerialController.h"
-#include "RingBuffer.h"
+#include "FrameQueue.h"
+#include "LatencyStats.h"
 #include "Defines.h"
 #include "Timer.h"
 
 #include <string>
+#include <thread>
+#include <atomic>
 
 enum RESP_TYPE_MMDVM {
 	RTM_OK,
@@ -31,6 +34,14 @@ enum RESP_TYPE_MMDVM {
 	RTM_ERROR
 };
 
+enum MODEM_RECOVERY {
+	MR_NONE,
+	MR_WAIT_OPEN,
+	MR_WAIT_VERSION,
+	MR_WAIT_FREQ,
+	MR_WAIT_CONFIG
+};
+
 class CModem {
 public:
 	CModem(const std::string& port, bool duplex, bool rxInvert, bool txInvert, bool pttInvert, unsigned int txDelay, unsigned int dmrDelay, bool trace, bool debug);
@@ -42,14 +53,16 @@ public:
 	virtual void setLevels(float rxLevel, float cwIdTXLevel, float dmrTXLevel, float pocsagLevel);
 	virtual void setDMRParams(unsigned int colorCode);
 	virtual void setTransparentDataParams(unsigned int sendFrameType);
+	virtual void setIOParams(bool ioThread, unsigned int frameBudget);
 
 	virtual bool open();
 
 	virtual bool hasDMR() const;
 	virtual bool hasPOCSAG() const;
 
-	virtual unsigned int readDMRData1(unsigned char* data);
-	virtual unsigned int readDMRData2(unsigned char* data);
+	// The timestamp is when the frame was read from the modem, or when it reached the host for writes
+	virtual unsigned int readDMRData1(unsigned char* data, unsigned long long& timestamp);
+	virtual unsigned int readDMRData2(unsigned char* data, unsigned long long& timestamp);
 	virtual unsigned int readTransparentData(unsigned char* data);
 
 	virtual bool hasDMRSpace1() const;
@@ -61,8 +74,8 @@ public:
 	virtual bool hasError() const;
 
 	virtual bool writeConfig();
-	virtual bool writeDMRData1(const unsigned char* data, unsigned int length);
-	virtual bool writeDMRData2(const unsigned char* data, unsigned int length);
+	virtual bool writeDMRData1(const unsigned char* data, unsigned int length, unsigned long long timestamp);
+	virtual bool writeDMRData2(const unsigned char* data, unsigned int length, unsigned long long timestamp);
 	virtual bool writePOCSAGData(const unsigned char* data, unsigned int length);
 
 	virtual bool writeTransparentData(const unsigned char* data, unsigned int length);
@@ -77,7 +90,10 @@ public:
 
 	virtual const char* getHWType() const;
 
-	virtual void clock(unsigned int ms);
+	virtual unsigned int clock(unsigned int ms);
+
+	virtual int  getFd() const;
+	virtual unsigned int getTimeout();
 
 	virtual void close();
 
@@ -110,35 +126,76 @@ private:
 	CSerialController*         m_serial;
 	unsigned char*             m_buffer;
 	unsigned int               m_length;
-	unsigned int               m_offset;
-	CRingBuffer<unsigned char> m_rxDMRData1;
-	CRingBuffer<unsigned char> m_rxDMRData2;
-	CRingBuffer<unsigned char> m_txDMRData1;
-	CRingBuffer<unsigned char> m_txDMRData2;
-	CRingBuffer<unsigned char> m_txPOCSAGData;
-	CRingBuffer<unsigned char> m_rxTransparentData;
-	CRingBuffer<unsigned char> m_txTransparentData;
+	unsigned char*             m_rxBuffer;
+	unsigned int               m_rxLength;
+	unsigned char*             m_txBuffer;
+	iovec*                     m_txIOV;
+	unsigned long long*        m_txTimestamps;
+	unsigned long long         m_rxTimestamp;
+	CFrameQueue                m_rxDMRData1;
+	CFrameQueue                m_rxDMRData2;
+	CFrameQueue                m_txDMRData1;
+	CFrameQueue                m_txDMRData2;
+	CFrameQueue                m_txPOCSAGData;
+	CFrameQueue                m_rxTransparentData;
+	CFrameQueue                m_txTransparentData;
+	CFrameQueue                m_txCommand;
 	unsigned int               m_sendTransparentDataFrameType;
 	CTimer                     m_statusTimer;
 	CTimer                     m_inactivityTimer;
 	CTimer                     m_playoutTimer;
+	CTimer                     m_recoveryTimer;
+	CTimer                     m_latencyTimer;
+	CLatencyStats              m_netLatency;
+	MODEM_RECOVERY             m_recovery;
+	unsigned int               m_recoveryCount;
 	unsigned int               m_dmrSpace1;
 	unsigned int               m_dmrSpace2;
 	unsigned int               m_pocsagSpace;
-	bool                       m_tx;
-	bool                       m_error;
+	std::atomic<bool>          m_tx;
+	std::atomic<bool>          m_error;
 	unsigned char              m_mode;
 	const char*                m_hwType;
 	unsigned char              m_capabilities1;
 	unsigned char              m_capabilities2;
+	bool                       m_ioThread;
+	unsigned int               m_frameBudget;
+	std::atomic<unsigned int>  m_rxFrames;
+	std::thread                m_thread;
+	std::atomic<bool>          m_running;
+	int                        m_rxNotify[2U];
+	int                        m_txNotify[2U];
+
+	bool openInt();
+	void closeInt();
+	unsigned int clockInt(unsigned int ms);
+	void clockRecovery(unsigned int ms);
+	void retryRecovery();
+	unsigned int getTimeoutInt();
+
+	bool startThread();
+	void stopThread();
+	void wakeThread();
+	void threadMain();
+
+	bool writeCommand(const unsigned char* buffer, unsigned int length);
 
 	bool readVersion();
+	bool writeVersion();
+	bool processVersion();
 	bool readStatus();
-	bool setConfig1();
-	bool setConfig2();
+	bool sendConfig();
+	bool sendConfig1();
+	bool sendConfig2();
 	bool setFrequency();
+	bool sendFrequency();
+	bool waitForAck(const char* command);
 
 	void printDebug();
 
+	bool hasResponse() const;
 	RESP_TYPE_MMDVM getResponse();
+	void processResponse();
+	void gatherTX(CFrameQueue& queue, const char* text, bool timestamped, unsigned int& count, unsigned int& offset);
+	unsigned int readTimestamped(CFrameQueue& queue, unsigned char* data, unsigned long long& timestamp);
 };
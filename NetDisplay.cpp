@@ -18,6 +18,7 @@
 
 #include "NetDisplay.h"
 
+#include "DNSResolver.h"
 #include "Log.h"
 
 #include <string.h>
@@ -28,7 +29,8 @@ m_socket(NULL),
 m_addressStr(address),
 m_addr(),
 m_addrLen(0U),
-m_port(port)
+m_port(port),
+m_waiting(false)
 {
 }
 
@@ -40,10 +42,10 @@ bool CNetDisplay::open()
 {
 	LogInfo("Display, opening socket");
 
-	if (CUDPSocket::lookup(m_addressStr, m_port, m_addr, m_addrLen) != 0) {
-		LogError("Display, Unable to resolve the address");
-		return 1;
-	}
+	// The socket is opened by write() once the resolver has the address
+	m_waiting = !CDNSResolver::lookup(m_addressStr, m_port, m_addr, m_addrLen);
+	if (m_waiting)
+		return true;
 
 	m_socket = new CUDPSocket();
 	int ret = m_socket->open(m_addr.ss_family);
@@ -58,6 +60,13 @@ bool CNetDisplay::open()
 
 void CNetDisplay::write(unsigned char* data, unsigned int length)
 {
+	if (m_waiting) {
+		if (!CDNSResolver::lookup(m_addressStr, m_port, m_addr, m_addrLen))
+			return;
+
+		open();
+	}
+
 	if (m_socket)
 		m_socket->write(data, length, m_addr, m_addrLen);
 }
@@ -55,6 +55,7 @@ private:
 	sockaddr_storage m_addr;
 	unsigned int     m_addrLen;
 	unsigned int     m_port;
+	bool             m_waiting;
 
 	void write(unsigned char* data, unsigned int length);
 };
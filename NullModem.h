@@ -41,8 +41,8 @@ public:
 	virtual bool hasDMR() const override {return true;};
 	virtual bool hasPOCSAG() const override {return true;};
 
-	virtual unsigned int readDMRData1(unsigned char* data) override {return 0;};
-	virtual unsigned int readDMRData2(unsigned char* data) override {return 0;};
+	virtual unsigned int readDMRData1(unsigned char* data, unsigned long long& timestamp) override {return 0;};
+	virtual unsigned int readDMRData2(unsigned char* data, unsigned long long& timestamp) override {return 0;};
 	virtual unsigned int readTransparentData(unsigned char* data) override {return 0;};
 
 	virtual bool hasDMRSpace1() const override {return true;};
@@ -53,8 +53,8 @@ public:
 
 	virtual bool hasError() const override {return false;};
 
-	virtual bool writeDMRData1(const unsigned char* data, unsigned int length) override {return true;};
-	virtual bool writeDMRData2(const unsigned char* data, unsigned int length) override {return true;};
+	virtual bool writeDMRData1(const unsigned char* data, unsigned int length, unsigned long long timestamp) override {return true;};
+	virtual bool writeDMRData2(const unsigned char* data, unsigned int length, unsigned long long timestamp) override {return true;};
 	virtual bool writePOCSAGData(const unsigned char* data, unsigned int length) override {return true;};
 
 	virtual bool writeTransparentData(const unsigned char* data, unsigned int length) override {return true;};
@@ -69,7 +69,10 @@ public:
 
 	virtual const char* getHWType() const override {return m_hwType;};
 
-	virtual void clock(unsigned int ms) override {};
+	virtual unsigned int clock(unsigned int ms) override { return 0U; };
+
+	virtual int  getFd() const override {return -1;};
+	virtual unsigned int getTimeout() override {return 1000U;};
 
 	virtual void close() override {};
 
@@ -89,15 +89,7 @@ unsigned int CPOCSAGControl::readModem(unsigned char* data)
 {
 	assert(data != NULL);
 
-	if (m_queue.isEmpty())
-		return 0U;
-
-	unsigned char len = 0U;
-	m_queue.getData(&len, 1U);
-
-	m_queue.getData(data, len);
-
-	return len;
+	return m_queue.getData(data);
 }
 
 bool CPOCSAGControl::readNetwork()
@@ -416,13 +408,11 @@ void CPOCSAGControl::writeQueue()
 
 	assert(len == POCSAG_FRAME_LENGTH_BYTES);
 
-	unsigned int space = m_queue.freeSpace();
-	if (space < (len + 1U)) {
+	if (!m_queue.hasSpace(len)) {
 		LogError("POCSAG, overflow in the POCSAG RF queue");
 		return;
 	}
 
-	m_queue.addData(&len, 1U);
 	m_queue.addData(data, len);
 }
 
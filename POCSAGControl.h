@@ -20,7 +20,7 @@
 
 #include "POCSAGNetwork.h"
 #include "POCSAGDefines.h"
-#include "RingBuffer.h"
+#include "FrameQueue.h"
 #include "Display.h"
 #include "Defines.h"
 
@@ -50,7 +50,7 @@ public:
 private:
 	CPOCSAGNetwork*            m_network;
 	CDisplay*                  m_display;
-	CRingBuffer<unsigned char> m_queue;
+	CFrameQueue                m_queue;
 	unsigned int               m_frames;
 	unsigned int               m_count;
 
@@ -18,6 +18,7 @@
 
 #include "POCSAGDefines.h"
 #include "POCSAGNetwork.h"
+#include "DNSResolver.h"
 #include "Defines.h"
 #include "Utils.h"
 #include "Log.h"
@@ -30,14 +31,15 @@ const unsigned int BUFFER_LENGTH = 200U;
 
 CPOCSAGNetwork::CPOCSAGNetwork(const std::string& myAddress, unsigned short myPort, const std::string& gatewayAddress, unsigned short gatewayPort, bool debug) :
 m_socket(myAddress, myPort),
+m_gatewayAddress(gatewayAddress),
+m_gatewayPort(gatewayPort),
 m_addr(),
 m_addrLen(0U),
 m_debug(debug),
 m_enabled(false),
 m_buffer(1000U, "POCSAG Network")
 {
-	if (CUDPSocket::lookup(gatewayAddress, gatewayPort, m_addr, m_addrLen) != 0)
-		m_addrLen = 0U;
+	CDNSResolver::lookup(m_gatewayAddress, m_gatewayPort, m_addr, m_addrLen);
 }
 
 CPOCSAGNetwork::~CPOCSAGNetwork()
@@ -46,10 +48,9 @@ CPOCSAGNetwork::~CPOCSAGNetwork()
 
 bool CPOCSAGNetwork::open()
 {
-	if (m_addrLen == 0U) {
-		LogError("Unable to resolve the address of the DAPNET Gateway");
-		return false;
-	}
+	// The resolver may still be working on it, the address is picked up once it has
+	if (m_addrLen == 0U)
+		LogWarning("The address of the DAPNET Gateway is not known yet");
 
 	LogMessage("Opening POCSAG network connection");
 
@@ -66,7 +67,7 @@ void CPOCSAGNetwork::clock(unsigned int ms)
 	if (length <= 0)
 		return;
 
-	if (!CUDPSocket::match(m_addr, address)) {
+	if (m_addrLen == 0U || !CUDPSocket::match(m_addr, address)) {
 		LogMessage("POCSAG, packet received from an invalid source");
 		return;
 	}
@@ -81,8 +82,6 @@ void CPOCSAGNetwork::clock(unsigned int ms)
 	if (!m_enabled)
 		return;
 
-	unsigned char len = length - 6U;
-	m_buffer.addData(&len, 1U);
 	m_buffer.addData(buffer + 6U, length - 6U);
 }
 
@@ -90,14 +89,7 @@ unsigned int CPOCSAGNetwork::read(unsigned char* data)
 {
 	assert(data != NULL);
 
-	if (m_buffer.isEmpty())
-		return 0U;
-
-	unsigned char len = 0U;
-	m_buffer.getData(&len, 1U);
-	m_buffer.getData(data, len);
-
-	return len;
+	return m_buffer.getData(data);
 }
 
 void CPOCSAGNetwork::reset()
@@ -111,6 +103,11 @@ void CPOCSAGNetwork::close()
 	LogMessage("Closing POCSAG network connection");
 }
 
+int CPOCSAGNetwork::getFd() const
+{
+	return m_socket.getFd();
+}
+
 void CPOCSAGNetwork::enable(bool enabled)
 {
 	if (enabled && !m_enabled)
@@ -118,9 +115,13 @@ void CPOCSAGNetwork::enable(bool enabled)
 	else if (!enabled && m_enabled)
 		m_buffer.clear();
 
-	unsigned char c = enabled ? 0x00U : 0xFFU;
-	
-	m_socket.write(&c, 1U, m_addr, m_addrLen);
-	
+	// Called regularly, so a good time to take any new address from the resolver
+	CDNSResolver::lookup(m_gatewayAddress, m_gatewayPort, m_addr, m_addrLen);
+
+	if (m_addrLen > 0U) {
+		unsigned char c = enabled ? 0x00U : 0xFFU;
+		m_socket.write(&c, 1U, m_addr, m_addrLen);
+	}
+
 	m_enabled = enabled;
 }
@@ -19,7 +19,7 @@
 #pragma once
 
 #include "POCSAGDefines.h"
-#include "RingBuffer.h"
+#include "FrameQueue.h"
 #include "UDPSocket.h"
 #include "Timer.h"
 
@@ -43,11 +43,15 @@ public:
 
 	void clock(unsigned int ms);
 
+	int  getFd() const;
+
 private:
 	CUDPSocket       m_socket;
+	std::string      m_gatewayAddress;
+	unsigned short   m_gatewayPort;
 	sockaddr_storage m_addr;
 	unsigned int     m_addrLen;
 	bool             m_debug;
 	bool             m_enabled;
-	CRingBuffer<unsigned char> m_buffer;
+	CFrameQueue                m_buffer;
 };
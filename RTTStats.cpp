@@ -0,0 +1,114 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "RTTStats.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+const unsigned int RTT_WINDOW = 256U;
+
+const unsigned int MIN_RTO = 100U;
+const unsigned int MAX_RTO = 10000U;
+
+CRTTStats::CRTTStats() :
+m_samples(NULL),
+m_count(0U),
+m_next(0U),
+m_srtt(0U),
+m_rttvar(0U),
+m_missed(0U)
+{
+	m_samples = new unsigned int[RTT_WINDOW];
+}
+
+CRTTStats::~CRTTStats()
+{
+	delete[] m_samples;
+}
+
+void CRTTStats::addSample(unsigned int ms)
+{
+	bool first = m_count == 0U;
+
+	m_samples[m_next] = ms;
+	m_next = (m_next + 1U) % RTT_WINDOW;
+	if (m_count < RTT_WINDOW)
+		m_count++;
+
+	// The smoothed RTT is held scaled by 8 and the variance by 4
+	if (first) {
+		m_srtt   = ms << 3;
+		m_rttvar = ms << 1;
+		return;
+	}
+
+	int delta = int(ms) - int(m_srtt >> 3);
+	m_srtt += delta;
+
+	if (delta < 0)
+		delta = -delta;
+	m_rttvar += delta - int(m_rttvar >> 2);
+}
+
+void CRTTStats::addMissed()
+{
+	m_missed++;
+}
+
+unsigned int CRTTStats::getRTO() const
+{
+	if (m_count == 0U)
+		return MAX_RTO;
+
+	unsigned int rto = (m_srtt >> 3) + m_rttvar;
+
+	return std::min(std::max(rto, MIN_RTO), MAX_RTO);
+}
+
+void CRTTStats::reset()
+{
+	m_count  = 0U;
+	m_next   = 0U;
+	m_srtt   = 0U;
+	m_rttvar = 0U;
+	m_missed = 0U;
+}
+
+void CRTTStats::logStats(const char* name) const
+{
+	if (m_count == 0U) {
+		LogMessage("%s, no round trip times, %u pongs missed", name, m_missed);
+		return;
+	}
+
+	unsigned int sorted[RTT_WINDOW];
+	::memcpy(sorted, m_samples, m_count * sizeof(unsigned int));
+	std::sort(sorted, sorted + m_count);
+
+	unsigned long long total = 0ULL;
+	for (unsigned int i = 0U; i < m_count; i++)
+		total += sorted[i];
+
+	unsigned int p95 = sorted[(m_count * 95U) / 100U];
+	unsigned int p99 = sorted[(m_count * 99U) / 100U];
+
+	LogMessage("%s, round trip over %u pings: min %ums, avg %ums, p95 %ums, p99 %ums, max %ums, %u pongs missed", name, m_count,
+		sorted[0U], (unsigned int)(total / m_count), p95, p99, sorted[m_count - 1U], m_missed);
+}
@@ -0,0 +1,45 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#pragma once
+
+// Round trip times of the pings to one master. The last RTT_WINDOW samples are kept for the
+// percentiles, and a smoothed RTT and variance are kept the way TCP does (RFC 6298).
+class CRTTStats {
+public:
+	CRTTStats();
+	~CRTTStats();
+
+	void addSample(unsigned int ms);
+	void addMissed();
+
+	// How long to allow for a reply, in ms
+	unsigned int getRTO() const;
+
+	void reset();
+
+	void logStats(const char* name) const;
+
+private:
+	unsigned int*  m_samples;
+	unsigned int   m_count;
+	unsigned int   m_next;
+	unsigned int   m_srtt;
+	unsigned int   m_rttvar;
+	unsigned int   m_missed;
+};
@@ -188,6 +188,27 @@ int CSerialController::read(unsigned char* buffer, unsigned int length)
 	return length;
 }
 
+int CSerialController::readAvailable(unsigned char* buffer, unsigned int length)
+{
+	assert(buffer != NULL);
+	assert(m_fd != -1);
+
+	if (length == 0U)
+		return 0;
+
+	// The port is opened non-blocking so this returns whatever has been received so far
+	ssize_t len = ::read(m_fd, buffer, length);
+	if (len < 0) {
+		if (errno == EAGAIN)
+			return 0;
+
+		LogError("Error from read(), errno=%d", errno);
+		return -1;
+	}
+
+	return int(len);
+}
+
 int CSerialController::write(const unsigned char* buffer, unsigned int length)
 {
 	assert(buffer != NULL);
@@ -205,6 +226,9 @@ int CSerialController::write(const unsigned char* buffer, unsigned int length)
 				LogError("Error returned from write(), errno=%d", errno);
 				return -1;
 			}
+
+			if (!waitWritable())
+				return -1;
 		}
 
 		if (n > 0)
@@ -214,6 +238,78 @@ int CSerialController::write(const unsigned char* buffer, unsigned int length)
 	return length;
 }
 
+int CSerialController::writev(iovec* iov, unsigned int count)
+{
+	assert(iov != NULL);
+	assert(m_fd != -1);
+
+	int total = 0;
+
+	while (count > 0U) {
+		ssize_t n = ::writev(m_fd, iov, int(count));
+		if (n < 0) {
+			if (errno != EAGAIN) {
+				LogError("Error returned from writev(), errno=%d", errno);
+				return -1;
+			}
+
+			if (!waitWritable())
+				return -1;
+
+			continue;
+		}
+
+		total += int(n);
+
+		// Skip the buffers that were sent in full and trim a partially sent one
+		while (count > 0U && size_t(n) >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			count--;
+		}
+
+		if (count > 0U) {
+			iov->iov_base = (unsigned char*)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+
+	return total;
+}
+
+bool CSerialController::waitWritable()
+{
+	// The output queue is full, wait for the port to drain rather than spinning
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(m_fd, &fds);
+
+	struct timeval tv;
+	tv.tv_sec  = 1;
+	tv.tv_usec = 0;
+
+	int n = ::select(m_fd + 1, NULL, &fds, NULL, &tv);
+	if (n < 0) {
+		if (errno == EINTR)
+			return true;
+
+		LogError("Error from select(), errno=%d", errno);
+		return false;
+	}
+
+	if (n == 0) {
+		LogError("Timed out waiting to write to the serial port");
+		return false;
+	}
+
+	return true;
+}
+
+int CSerialController::getFd() const
+{
+	return m_fd;
+}
+
 void CSerialController::close()
 {
 	assert(m_fd != -1);
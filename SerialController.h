@@ -23,6 +23,8 @@
 
 #include <string>
 
+#include <sys/uio.h>
+
 class CSerialController : public ISerialPort {
 public:
 	CSerialController(const std::string& device, unsigned int speed, bool assertRTS = false);
@@ -32,13 +34,22 @@ public:
 
 	virtual int read(unsigned char* buffer, unsigned int length) override;
 
+	virtual int readAvailable(unsigned char* buffer, unsigned int length);
+
 	virtual int write(const unsigned char* buffer, unsigned int length) override;
 
+	// Writes the buffers in order, the iovec array is updated as data goes out
+	virtual int writev(iovec* iov, unsigned int count);
+
 	virtual void close() override;
 
+	int getFd() const;
+
 protected:
 	std::string    m_device;
 	unsigned int   m_speed;
 	bool           m_assertRTS;
 	int            m_fd;
+
+	bool waitWritable();
 };
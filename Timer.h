@@ -36,6 +36,17 @@ public:
 		return (m_timeout - m_timer) / m_ticksPerSec;
 	}
 
+	unsigned int getRemainingMS()
+	{
+		if (m_timeout == 0U || m_timer == 0U)
+			return 0U;
+
+		if (m_timer >= m_timeout)
+			return 0U;
+
+		return (unsigned int)(((m_timeout - m_timer) * 1000ULL) / m_ticksPerSec);
+	}
+
 	bool isRunning()
 	{
 		return m_timer > 0U;
@@ -21,18 +21,35 @@
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <cstdint>
 #include "Log.h"
 
+const unsigned int UDP_BATCH_SIZE = 16U;
+
 CUDPSocket::CUDPSocket(const std::string& address, unsigned short port) :
 m_address(address),
 m_port(port),
-m_fd(-1)
+m_fd(-1),
+m_rxBuffer(0U),
+m_txBuffer(0U),
+m_dscp(0U),
+m_priority(0U),
+m_busyPoll(0U),
+m_drops(0U),
+m_socketDrops(0U)
 {
 }
 
 CUDPSocket::CUDPSocket(unsigned short port) :
 m_port(port),
-m_fd(-1)
+m_fd(-1),
+m_rxBuffer(0U),
+m_txBuffer(0U),
+m_dscp(0U),
+m_priority(0U),
+m_busyPoll(0U),
+m_drops(0U),
+m_socketDrops(0U)
 {
 }
 
@@ -95,6 +112,15 @@ bool CUDPSocket::match(const sockaddr_storage& addr1, const sockaddr_storage& ad
 	}
 }
 
+void CUDPSocket::setOptions(unsigned int rxBuffer, unsigned int txBuffer, unsigned int dscp, unsigned int priority, unsigned int busyPoll)
+{
+	m_rxBuffer = rxBuffer;
+	m_txBuffer = txBuffer;
+	m_dscp     = dscp;
+	m_priority = priority;
+	m_busyPoll = busyPoll;
+}
+
 bool CUDPSocket::open(unsigned int af)
 {
 	return open(af, m_address, m_port);
@@ -123,6 +149,22 @@ bool CUDPSocket::open(const unsigned int af, const std::string& address, const u
 		return false;
 	}
 
+#if defined(SO_TIMESTAMPNS)
+	// Have the kernel stamp each datagram on arrival, only used for tracing so failure is not fatal
+	int stamp = 1;
+	if (::setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, (char *)&stamp, sizeof(stamp)) == -1)
+		LogWarning("Cannot enable UDP receive timestamps, err: %d", errno);
+#endif
+
+#if defined(SO_RXQ_OVFL)
+	// Each datagram then carries the count of those dropped for want of buffer space
+	int ovfl = 1;
+	if (::setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, (char *)&ovfl, sizeof(ovfl)) == -1)
+		LogWarning("Cannot enable UDP drop counting, err: %d", errno);
+#endif
+
+	applyOptions(addr.ss_family);
+
 	if (port > 0U) {
 		int reuse = 1;
 		if (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse)) == -1) {
@@ -141,6 +183,79 @@ bool CUDPSocket::open(const unsigned int af, const std::string& address, const u
 	return true;
 }
 
+static bool getOption(int fd, int level, int name, int& value)
+{
+	socklen_t len = sizeof(int);
+
+	return ::getsockopt(fd, level, name, (char *)&value, &len) == 0;
+}
+
+void CUDPSocket::applyOptions(int family)
+{
+	// None of these are fatal, the socket still works without them
+	if (m_rxBuffer > 0U) {
+		int size = int(m_rxBuffer);
+		if (::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, (char *)&size, sizeof(size)) == -1)
+			LogWarning("Cannot set the UDP receive buffer size, err: %d", errno);
+	}
+
+	if (m_txBuffer > 0U) {
+		int size = int(m_txBuffer);
+		if (::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, (char *)&size, sizeof(size)) == -1)
+			LogWarning("Cannot set the UDP send buffer size, err: %d", errno);
+	}
+
+	if (m_dscp > 0U) {
+		// The DSCP is the top six bits of the TOS or traffic class byte
+		int tos = int(m_dscp << 2);
+		int ret;
+		if (family == AF_INET6)
+			ret = ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_TCLASS, (char *)&tos, sizeof(tos));
+		else
+			ret = ::setsockopt(m_fd, IPPROTO_IP, IP_TOS, (char *)&tos, sizeof(tos));
+		if (ret == -1)
+			LogWarning("Cannot set the UDP DSCP, err: %d", errno);
+	}
+
+#if defined(SO_PRIORITY)
+	if (m_priority > 0U) {
+		int priority = int(m_priority);
+		if (::setsockopt(m_fd, SOL_SOCKET, SO_PRIORITY, (char *)&priority, sizeof(priority)) == -1)
+			LogWarning("Cannot set the UDP socket priority, err: %d", errno);
+	}
+#endif
+
+#if defined(SO_BUSY_POLL)
+	if (m_busyPoll > 0U) {
+		int busyPoll = int(m_busyPoll);
+		if (::setsockopt(m_fd, SOL_SOCKET, SO_BUSY_POLL, (char *)&busyPoll, sizeof(busyPoll)) == -1)
+			LogWarning("Cannot set the UDP busy poll time, err: %d", errno);
+	}
+#endif
+
+	// The kernel may round or cap what was asked for, so report what it actually gave, its defaults included
+	int rxBuffer = 0, txBuffer = 0, tos = 0, priority = 0, busyPoll = 0;
+
+	bool ret = getOption(m_fd, SOL_SOCKET, SO_RCVBUF, rxBuffer) && getOption(m_fd, SOL_SOCKET, SO_SNDBUF, txBuffer);
+	if (family == AF_INET6)
+		ret = ret && getOption(m_fd, IPPROTO_IPV6, IPV6_TCLASS, tos);
+	else
+		ret = ret && getOption(m_fd, IPPROTO_IP, IP_TOS, tos);
+#if defined(SO_PRIORITY)
+	ret = ret && getOption(m_fd, SOL_SOCKET, SO_PRIORITY, priority);
+#endif
+#if defined(SO_BUSY_POLL)
+	ret = ret && getOption(m_fd, SOL_SOCKET, SO_BUSY_POLL, busyPoll);
+#endif
+
+	if (!ret) {
+		LogWarning("Cannot read back the UDP socket options, err: %d", errno);
+		return;
+	}
+
+	LogInfo("UDP socket options: receive buffer %d, send buffer %d, DSCP %d, priority %d, busy poll %dus", rxBuffer, txBuffer, (tos >> 2) & 0x3F, priority, busyPoll);
+}
+
 int CUDPSocket::read(unsigned char* buffer, unsigned int length, sockaddr_storage& address, unsigned int &address_length)
 {
 	assert(buffer != NULL);
@@ -201,8 +316,164 @@ bool CUDPSocket::write(const unsigned char* buffer, unsigned int length, const s
 	return result;
 }
 
+int CUDPSocket::read(UDPMessage* messages, unsigned int count, unsigned int length)
+{
+	assert(messages != NULL);
+	assert(count > 0U);
+	assert(length > 0U);
+
+	if (m_fd < 0)
+		return 0;
+
+#if defined(__linux__)
+	if (count > UDP_BATCH_SIZE)
+		count = UDP_BATCH_SIZE;
+
+	mmsghdr msgs[UDP_BATCH_SIZE];
+	iovec iov[UDP_BATCH_SIZE];
+	unsigned char control[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t))];
+	::memset(msgs, 0x00U, count * sizeof(mmsghdr));
+
+	for (unsigned int i = 0U; i < count; i++) {
+		iov[i].iov_base = messages[i].buffer;
+		iov[i].iov_len  = length;
+
+		msgs[i].msg_hdr.msg_name    = &messages[i].address;
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+		msgs[i].msg_hdr.msg_iov     = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen  = 1U;
+		msgs[i].msg_hdr.msg_control    = control[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+	}
+
+	// Return immediately with whatever is queued
+	int ret = ::recvmmsg(m_fd, msgs, count, MSG_DONTWAIT, NULL);
+	if (ret < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0;
+
+		LogError("Error returned from recvmmsg, err: %d", errno);
+
+		if (errno == ENOTSOCK) {
+			LogMessage("Re-opening UDP port on %hu", m_port);
+			close();
+			open();
+		}
+		return -1;
+	}
+
+	for (int i = 0; i < ret; i++) {
+		messages[i].length        = msgs[i].msg_len;
+		messages[i].addressLength = msgs[i].msg_hdr.msg_namelen;
+		messages[i].timestamp     = 0ULL;
+
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				timespec ts;
+				::memcpy(&ts, CMSG_DATA(cmsg), sizeof(timespec));
+				messages[i].timestamp = (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+			}
+#if defined(SO_RXQ_OVFL)
+			// A running total for the socket, only sent when it is non-zero
+			if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+				uint32_t drops;
+				::memcpy(&drops, CMSG_DATA(cmsg), sizeof(uint32_t));
+				m_socketDrops = drops;
+			}
+#endif
+		}
+	}
+
+	return ret;
+#else
+	unsigned int n = 0U;
+
+	while (n < count) {
+		int len = read(messages[n].buffer, length, messages[n].address, messages[n].addressLength);
+		if (len < 0)
+			return n > 0U ? int(n) : -1;
+		if (len == 0)
+			break;
+
+		messages[n].length    = len;
+		messages[n].timestamp = 0ULL;
+		n++;
+	}
+
+	return int(n);
+#endif
+}
+
+unsigned int CUDPSocket::write(const UDPMessage* messages, unsigned int count)
+{
+	assert(messages != NULL);
+
+#if defined(__linux__)
+	mmsghdr msgs[UDP_BATCH_SIZE];
+	iovec iov[UDP_BATCH_SIZE];
+
+	unsigned int offset = 0U;
+	while (offset < count) {
+		unsigned int n = count - offset;
+		if (n > UDP_BATCH_SIZE)
+			n = UDP_BATCH_SIZE;
+
+		::memset(msgs, 0x00U, n * sizeof(mmsghdr));
+
+		for (unsigned int i = 0U; i < n; i++) {
+			const UDPMessage& message = messages[offset + i];
+			assert(message.buffer != NULL);
+			assert(message.length > 0U);
+
+			iov[i].iov_base = message.buffer;
+			iov[i].iov_len  = message.length;
+
+			msgs[i].msg_hdr.msg_name    = (void*)&message.address;
+			msgs[i].msg_hdr.msg_namelen = message.addressLength;
+			msgs[i].msg_hdr.msg_iov     = &iov[i];
+			msgs[i].msg_hdr.msg_iovlen  = 1U;
+		}
+
+		int ret = ::sendmmsg(m_fd, msgs, n, 0);
+		if (ret <= 0) {
+			LogError("Error returned from sendmmsg, err: %d", errno);
+			return offset;
+		}
+
+		// A short count means the next datagram failed, sendmmsg reports its error on the next call
+		offset += ret;
+	}
+
+	return count;
+#else
+	for (unsigned int i = 0U; i < count; i++) {
+		if (!write(messages[i].buffer, messages[i].length, messages[i].address, messages[i].addressLength))
+			return i;
+	}
+
+	return count;
+#endif
+}
+
 void CUDPSocket::close()
 {
-	::close(m_fd);
+	if (m_fd >= 0) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+
+	// The kernel count starts again with the next socket
+	m_drops      += m_socketDrops;
+	m_socketDrops = 0U;
+}
+
+int CUDPSocket::getFd() const
+{
+	return m_fd;
+}
+
+unsigned int CUDPSocket::getDrops() const
+{
+	return m_drops + m_socketDrops;
 }
 
@@ -28,20 +28,43 @@
 #include <arpa/inet.h>
 #include <errno.h>
 
+struct UDPMessage {
+	unsigned char*   buffer;
+	unsigned int     length;
+	sockaddr_storage address;
+	unsigned int     addressLength;
+	// Kernel receive time when reading, or when the payload first reached the host when
+	// writing, in ns on the realtime clock. Zero when not known.
+	unsigned long long timestamp;
+};
+
 class CUDPSocket {
 public:
 	CUDPSocket(const std::string& address, unsigned short port = 0U);
 	CUDPSocket(unsigned short port = 0U);
 	~CUDPSocket();
 
+	// Applied by the next open(), zero leaves each one at the system default
+	void setOptions(unsigned int rxBuffer, unsigned int txBuffer, unsigned int dscp, unsigned int priority, unsigned int busyPoll);
+
 	bool open(unsigned int af = AF_UNSPEC);
 	bool open(const unsigned int af, const std::string& address, const unsigned short port);
 
 	int  read(unsigned char* buffer, unsigned int length, sockaddr_storage& address, unsigned int &address_length);
 	bool write(const unsigned char* buffer, unsigned int length, const sockaddr_storage& address, unsigned int address_length);
 
+	// Batched versions, each message buffer must have room for length bytes when reading,
+	// writing stops at the first datagram that fails and returns how many went before it
+	int  read(UDPMessage* messages, unsigned int count, unsigned int length);
+	unsigned int write(const UDPMessage* messages, unsigned int count);
+
 	void close();
 
+	int  getFd() const;
+
+	// Datagrams the kernel dropped because the receive buffer was full, where the kernel reports it
+	unsigned int getDrops() const;
+
 	static int lookup(const std::string& hostName, unsigned short port, sockaddr_storage& address, unsigned int& address_length);
 	static int lookup(const std::string& hostName, unsigned short port, sockaddr_storage& address, unsigned int& address_length, struct addrinfo& hints);
 
@@ -51,4 +74,13 @@ private:
 	std::string    m_address;
 	unsigned short m_port;
 	int            m_fd;
+	unsigned int   m_rxBuffer;
+	unsigned int   m_txBuffer;
+	unsigned int   m_dscp;
+	unsigned int   m_priority;
+	unsigned int   m_busyPoll;
+	unsigned int   m_drops;
+	unsigned int   m_socketDrops;
+
+	void applyOptions(int family);
 };
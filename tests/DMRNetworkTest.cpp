@@ -0,0 +1,679 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FakeStopWatch.h"
+#include "DNSResolver.h"
+#include "DMRNetwork.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+#include <chrono>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <dlfcn.h>
+
+const unsigned int STEP = 10U;
+
+const unsigned int BURST_FRAMES = 122U;
+
+// How long the stand-in resolver holds each answer for slow.test, and the most a network call may take
+const unsigned int SLOW_LOOKUP_TIME = 2000U;
+const unsigned int MAX_CALL_TIME    = 10U;
+
+// Stands in for the system resolver, slow.test answers as the loopback address after a long wait and
+// every other name is passed on
+extern "C" int getaddrinfo(const char* node, const char* service, const addrinfo* hints, addrinfo** res)
+{
+	typedef int (*GETADDRINFO)(const char*, const char*, const addrinfo*, addrinfo**);
+	static GETADDRINFO real = (GETADDRINFO)::dlsym(RTLD_NEXT, "getaddrinfo");
+
+	if (node == NULL || ::strcmp(node, "slow.test") != 0)
+		return real(node, service, hints, res);
+
+	::usleep(SLOW_LOOKUP_TIME * 1000U);
+
+	addrinfo numeric;
+	::memset(&numeric, 0x00U, sizeof(numeric));
+	if (hints != NULL)
+		numeric = *hints;
+	numeric.ai_flags |= AI_NUMERICHOST;
+
+	return real("127.0.0.1", service, &numeric, res);
+}
+
+static unsigned int elapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Just enough of a Homebrew master on the loopback interface to log a repeater in and answer its pings
+class CFakeMaster {
+public:
+	CFakeMaster() :
+	m_alive(true),
+	m_logins(0U),
+	m_dmrd(0U),
+	m_fd(-1),
+	m_port(0U),
+	m_peer()
+	{
+		m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+		CHECK(m_fd >= 0);
+
+		sockaddr_in addr;
+		::memset(&addr, 0x00U, sizeof(addr));
+		addr.sin_family      = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port        = 0U;
+		CHECK(::bind(m_fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+
+		socklen_t len = sizeof(addr);
+		CHECK(::getsockname(m_fd, (sockaddr*)&addr, &len) == 0);
+		m_port = ntohs(addr.sin_port);
+
+		::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+	}
+
+	~CFakeMaster()
+	{
+		::close(m_fd);
+	}
+
+	unsigned short getPort() const
+	{
+		return m_port;
+	}
+
+	unsigned short getPeerPort() const
+	{
+		return ntohs(m_peer.sin_port);
+	}
+
+	void clock()
+	{
+		unsigned char buffer[500U];
+		sockaddr_in addr;
+		socklen_t len = sizeof(addr);
+
+		int n;
+		while ((n = ::recvfrom(m_fd, buffer, sizeof(buffer), 0, (sockaddr*)&addr, &len)) > 0) {
+			if (!m_alive)
+				continue;
+
+			m_peer = addr;
+
+			if (::memcmp(buffer, "RPTL", 4U) == 0)
+				m_logins++;
+
+			if (::memcmp(buffer, "RPTL", 4U) == 0 || ::memcmp(buffer, "RPTK", 4U) == 0 || ::memcmp(buffer, "RPTC", 4U) == 0)
+				send("RPTACK\x01\x02\x03\x04", 10U);
+			else if (n >= 7 && ::memcmp(buffer, "RPTPING", 7U) == 0)
+				send("MSTPONG\x00\x00\x00\x00", 11U);
+			else if (::memcmp(buffer, "DMRD", 4U) == 0)
+				m_dmrd++;
+		}
+	}
+
+	void sendClose()
+	{
+		send("MSTCL\x00\x00\x00\x00", 9U);
+	}
+
+	void sendNak()
+	{
+		send("MSTNAK\x00\x12\xD6\x87", 10U);
+	}
+
+	// A voice frame on slot 2 to TG 9, the first of each superframe carrying the voice sync
+	void sendDMRD(unsigned int streamId, unsigned char seqNo, unsigned char n)
+	{
+		unsigned char buffer[55U];
+		::memset(buffer, 0x00U, sizeof(buffer));
+
+		::memcpy(buffer, "DMRD", 4U);
+		buffer[4U]  = seqNo;
+		buffer[7U]  = 0x01U;
+		buffer[10U] = 9U;
+		buffer[15U] = 0x80U | (n == 0U ? 0x10U : n);
+		buffer[16U] = streamId >> 24;
+		buffer[17U] = streamId >> 16;
+		buffer[18U] = streamId >> 8;
+		buffer[19U] = streamId >> 0;
+
+		send((const char*)buffer, sizeof(buffer));
+	}
+
+	bool         m_alive;
+	unsigned int m_logins;
+	unsigned int m_dmrd;
+
+private:
+	int            m_fd;
+	unsigned short m_port;
+	sockaddr_in    m_peer;
+
+	void send(const char* data, unsigned int length)
+	{
+		::sendto(m_fd, data, length, 0, (sockaddr*)&m_peer, sizeof(m_peer));
+	}
+};
+
+static CDMRNetwork* createNetwork(CFakeMaster& primary, CFakeMaster* secondary)
+{
+	CDMRNetwork* network = new CDMRNetwork("127.0.0.1", primary.getPort(), 1234567U, "passw0rd", true, "Test", false, true, true, "MMDVM");
+	if (secondary != NULL)
+		network->setSecondary("127.0.0.1", secondary->getPort(), "passw0rd");
+	network->setConfig("N0CALL", 439000000U, 439000000U, 1U, 1U, 0.0F, 0.0F, 0, "Nowhere", "Test", "");
+
+	CHECK(network->open());
+	network->enable(true);
+
+	return network;
+}
+
+// Runs the network and the masters for the given time, sending a voice frame on slot 2 every 60ms
+static void run(CDMRNetwork& network, CFakeMaster& primary, CFakeMaster* secondary, unsigned int ms)
+{
+	for (unsigned int elapsed = 0U; elapsed < ms; elapsed += STEP) {
+		g_fakeTime += STEP;
+
+		network.clock(STEP);
+
+		if ((elapsed % 60U) == 0U) {
+			CDMRData data;
+			data.setSlotNo(2U);
+			data.setSrcId(1234567U);
+			data.setDstId(9U);
+			data.setFLCO(FLCO_GROUP);
+			data.setDataType(DT_VOICE);
+			data.setN(1U);
+			network.write(data);
+		}
+
+		network.flush();
+
+		primary.clock();
+		if (secondary != NULL)
+			secondary->clock();
+	}
+}
+
+// Clocks the network until it has nothing more to read, returning the sequence numbers read from slot 2
+static std::vector<unsigned char> drain(CDMRNetwork& network)
+{
+	std::vector<unsigned char> seqNos;
+
+	// Loopback delivery is quick but not instant
+	for (unsigned int i = 0U; i < 20U; i++) {
+		::usleep(1000);
+		network.clock(0U);
+
+		CDMRData data;
+		while (network.read(2U, data))
+			seqNos.push_back(data.getSeqNo());
+	}
+
+	return seqNos;
+}
+
+// The missed pong count from the master's round trip line in the log
+static unsigned int missedPongs(const std::string& text, const char* master)
+{
+	std::string::size_type pos = text.find(std::string("DMR, ") + master + " master, round trip over");
+	CHECK(pos != std::string::npos);
+
+	pos = text.find(" max ", pos);
+	CHECK(pos != std::string::npos);
+
+	unsigned int max = 0U;
+	unsigned int missed = 0U;
+	CHECK(::sscanf(text.c_str() + pos, " max %ums, %u pongs missed", &max, &missed) == 2);
+
+	return missed;
+}
+
+// A whole call arriving in one burst is read in one pass and reaches the slot intact, and a whole call
+// written in one pass reaches the master
+static void testBurst()
+{
+	CFakeMaster primary;
+
+	CDMRNetwork* network = createNetwork(primary, NULL);
+
+	run(*network, primary, NULL, 15000U);
+
+	// Seven seconds of voice
+	for (unsigned int i = 0U; i < BURST_FRAMES; i++)
+		primary.sendDMRD(0x1234U, i, i % 6U);
+
+	std::vector<unsigned char> seqNos = drain(*network);
+	CHECK(seqNos.size() == BURST_FRAMES);
+	for (unsigned int i = 0U; i < seqNos.size(); i++)
+		CHECK(seqNos[i] == (unsigned char)i);
+
+	unsigned int dmrd = primary.m_dmrd;
+	for (unsigned int i = 0U; i < BURST_FRAMES; i++) {
+		CDMRData data;
+		data.setSlotNo(2U);
+		data.setSrcId(1234567U);
+		data.setDstId(9U);
+		data.setFLCO(FLCO_GROUP);
+		data.setDataType(DT_VOICE);
+		data.setN(1U);
+		CHECK(network->write(data));
+	}
+
+	network->flush();
+	::usleep(10000);
+	primary.clock();
+
+	CHECK(primary.m_dmrd == dmrd + BURST_FRAMES);
+
+	network->close();
+	delete network;
+}
+
+// When the primary stops answering, traffic moves to the logged in secondary within a couple of seconds
+static void testFailover()
+{
+	CFakeMaster primary;
+	CFakeMaster secondary;
+
+	CDMRNetwork* network = createNetwork(primary, &secondary);
+
+	run(*network, primary, &secondary, 15000U);
+
+	CHECK(primary.m_logins > 0U);
+	CHECK(secondary.m_logins > 0U);
+	CHECK(primary.m_dmrd > 0U);
+	CHECK(secondary.m_dmrd == 0U);
+
+	primary.m_alive = false;
+
+	run(*network, primary, &secondary, 2000U);
+
+	CHECK(secondary.m_dmrd > 0U);
+
+	// The secondary keeps the traffic once it has it
+	unsigned int dmrd = secondary.m_dmrd;
+	run(*network, primary, &secondary, 2000U);
+	CHECK(secondary.m_dmrd > dmrd);
+
+	// Both masters have their round trip times logged on close, and the silent primary its missed pongs
+	std::string text = captureLog([&]() {
+		network->close();
+	});
+
+	CHECK(text.find("DMR, primary master, round trip over") != std::string::npos);
+	CHECK(text.find("DMR, secondary master, round trip over") != std::string::npos);
+	CHECK(missedPongs(text, "primary") > 0U);
+	CHECK(missedPongs(text, "secondary") == 0U);
+
+	delete network;
+}
+
+// With a standby the shared socket, and so the source port, survives the primary closing down
+static void testStandbyKeepsSocket()
+{
+	CFakeMaster primary;
+	CFakeMaster secondary;
+
+	CDMRNetwork* network = createNetwork(primary, &secondary);
+
+	run(*network, primary, &secondary, 15000U);
+
+	unsigned short port   = primary.getPeerPort();
+	unsigned int   logins = primary.m_logins;
+
+	primary.sendClose();
+	run(*network, primary, &secondary, 15000U);
+
+	CHECK(primary.m_logins > logins);
+	CHECK(primary.getPeerPort() == port);
+	CHECK(secondary.getPeerPort() == port);
+
+	network->close();
+	delete network;
+}
+
+// Without a standby a master closing down gets a new socket, in case the old source port is what failed
+static void testSingleMasterReopens()
+{
+	CFakeMaster primary;
+
+	CDMRNetwork* network = createNetwork(primary, NULL);
+
+	run(*network, primary, NULL, 15000U);
+
+	unsigned short port   = primary.getPeerPort();
+	unsigned int   logins = primary.m_logins;
+	unsigned int   dmrd   = primary.m_dmrd;
+	CHECK(dmrd > 0U);
+
+	primary.sendClose();
+	run(*network, primary, NULL, 15000U);
+
+	CHECK(primary.m_logins > logins);
+	CHECK(primary.getPeerPort() != port);
+	CHECK(primary.m_dmrd > dmrd);
+
+	network->close();
+	delete network;
+}
+
+static std::vector<unsigned char> seqNos(std::initializer_list<unsigned char> list)
+{
+	return std::vector<unsigned char>(list);
+}
+
+// Duplicates and the tail of an earlier stream are dropped, stragglers within the window are kept, and a
+// jump ahead, or a step back after a silence, starts the window again rather than losing the stream
+static void testSeqNo()
+{
+	CFakeMaster primary;
+
+	CDMRNetwork* network = createNetwork(primary, NULL);
+
+	run(*network, primary, NULL, 15000U);
+
+	for (unsigned int i = 0U; i < 10U; i++)
+		primary.sendDMRD(0x1111U, i, i % 6U);
+	CHECK(drain(*network).size() == 10U);
+
+	primary.sendDMRD(0x1111U, 5U, 5U);
+	primary.sendDMRD(0x1111U, 9U, 3U);
+	CHECK(drain(*network).empty());
+
+	primary.sendDMRD(0x1111U, 11U, 5U);
+	primary.sendDMRD(0x1111U, 10U, 4U);
+	CHECK(drain(*network) == seqNos({ 11U, 10U }));
+
+	primary.sendDMRD(0x2222U, 0U, 0U);
+	primary.sendDMRD(0x1111U, 12U, 0U);
+	CHECK(drain(*network) == seqNos({ 0U }));
+
+	// 150 ahead is more than half way round, so it looks like 106 behind
+	primary.sendDMRD(0x2222U, 1U, 1U);
+	primary.sendDMRD(0x2222U, 151U, 1U);
+	primary.sendDMRD(0x2222U, 152U, 2U);
+	primary.sendDMRD(0x2222U, 151U, 1U);
+	CHECK(drain(*network) == seqNos({ 1U, 151U, 152U }));
+
+	g_fakeTime += 2000U;
+
+	primary.sendDMRD(0x2222U, 151U, 1U);
+	primary.sendDMRD(0x2222U, 152U, 2U);
+	CHECK(drain(*network) == seqNos({ 151U, 152U }));
+
+	std::string text = captureLog([&]() {
+		network->close();
+	});
+
+	CHECK(text.find("DMR, Slot 2, 3 duplicate and 1 late packets discarded") != std::string::npos);
+
+	delete network;
+}
+
+// Each session only takes the slots and talkgroups routed to it
+static void testRouting()
+{
+	CFakeMaster master1;
+	CFakeMaster master2;
+	CFakeMaster master3;
+
+	std::vector<std::pair<unsigned int, unsigned int>> ranges;
+	ranges.push_back(std::make_pair(1U, 9U));
+
+	CDMRNetwork* slot1 = new CDMRNetwork("127.0.0.1", master1.getPort(), 1234567U, "passw0rd", true, "Test", false, true, false, "MMDVM");
+	CDMRNetwork* slot2 = new CDMRNetwork("127.0.0.1", master2.getPort(), 1234567U, "passw0rd", true, "Test", false, false, true, "MMDVM");
+	slot2->setTGRanges(ranges);
+
+	ranges[0U].second = 8U;
+	CDMRNetwork* narrow = new CDMRNetwork("127.0.0.1", master3.getPort(), 1234567U, "passw0rd", true, "Test", false, false, true, "MMDVM");
+	narrow->setTGRanges(ranges);
+
+	CDMRNetwork* networks[] = { slot1, slot2, narrow };
+	CFakeMaster* masters[]  = { &master1, &master2, &master3 };
+
+	for (unsigned int i = 0U; i < 3U; i++) {
+		networks[i]->setConfig("N0CALL", 439000000U, 439000000U, 1U, 1U, 0.0F, 0.0F, 0, "Nowhere", "Test", "");
+		CHECK(networks[i]->open());
+		networks[i]->enable(true);
+
+		run(*networks[i], *masters[i], NULL, 15000U);
+	}
+
+	// Private calls only follow the slots
+	CHECK(slot1->routes(1U, FLCO_GROUP, 9U));
+	CHECK(!slot1->routes(2U, FLCO_GROUP, 9U));
+	CHECK(slot2->routes(2U, FLCO_GROUP, 9U));
+	CHECK(!narrow->routes(2U, FLCO_GROUP, 9U));
+	CHECK(narrow->routes(2U, FLCO_USER_USER, 9U));
+	CHECK(!narrow->routes(1U, FLCO_USER_USER, 9U));
+
+	// Voice on slot 2 to TG 9 from each master
+	for (unsigned int i = 0U; i < 3U; i++) {
+		for (unsigned int n = 0U; n < 6U; n++)
+			masters[i]->sendDMRD(0x9999U, n, n);
+	}
+
+	CHECK(drain(*slot1).empty());
+	CHECK(drain(*slot2).size() == 6U);
+	CHECK(drain(*narrow).empty());
+
+	for (unsigned int i = 0U; i < 3U; i++) {
+		networks[i]->close();
+		delete networks[i];
+	}
+}
+
+// With both masters relaying the same stream each frame is read once, whichever copy arrives first and
+// across the move to the secondary
+static void testDuplicateStream()
+{
+	CFakeMaster primary;
+	CFakeMaster secondary;
+
+	CDMRNetwork* network = createNetwork(primary, &secondary);
+
+	run(*network, primary, &secondary, 15000U);
+
+	for (unsigned int i = 0U; i < 60U; i++) {
+		primary.sendDMRD(0x5678U, i, i % 6U);
+		secondary.sendDMRD(0x5678U, i, i % 6U);
+	}
+
+	std::vector<unsigned char> seqNos = drain(*network);
+	CHECK(seqNos.size() == 60U);
+	for (unsigned int i = 0U; i < seqNos.size(); i++)
+		CHECK(seqNos[i] == (unsigned char)i);
+
+	for (unsigned int i = 60U; i < 90U; i++) {
+		secondary.sendDMRD(0x5678U, i, i % 6U);
+		primary.sendDMRD(0x5678U, i, i % 6U);
+	}
+
+	seqNos = drain(*network);
+	CHECK(seqNos.size() == 30U);
+	for (unsigned int i = 0U; i < seqNos.size(); i++)
+		CHECK(seqNos[i] == (unsigned char)(60U + i));
+
+	// The primary goes quiet mid-stream while the secondary carries on relaying it, a few frames behind
+	primary.m_alive = false;
+
+	unsigned int seqNo = 85U;
+	seqNos.clear();
+	for (unsigned int elapsed = 0U; elapsed < 3000U; elapsed += STEP) {
+		g_fakeTime += STEP;
+
+		if ((elapsed % 60U) == 0U) {
+			secondary.sendDMRD(0x5678U, seqNo, seqNo % 6U);
+			seqNo++;
+		}
+
+		::usleep(100);
+		network->clock(STEP);
+
+		CDMRData data;
+		while (network->read(2U, data))
+			seqNos.push_back(data.getSeqNo());
+
+		network->flush();
+
+		primary.clock();
+		secondary.clock();
+	}
+
+	std::vector<unsigned char> tail = drain(*network);
+	seqNos.insert(seqNos.end(), tail.begin(), tail.end());
+
+	CHECK(!seqNos.empty());
+	CHECK(seqNos.front() >= 90U);
+	CHECK(seqNos.back() == (unsigned char)(seqNo - 1U));
+	for (unsigned int i = 1U; i < seqNos.size(); i++)
+		CHECK(seqNos[i] == seqNos[i - 1U] + 1U);
+
+	network->close();
+	delete network;
+}
+
+// A master refusing a running repeater only gets a new login, the socket and its source port are kept
+static void testNakRelogsIn()
+{
+	CFakeMaster primary;
+
+	CDMRNetwork* network = createNetwork(primary, NULL);
+
+	run(*network, primary, NULL, 15000U);
+
+	unsigned short port   = primary.getPeerPort();
+	unsigned int   logins = primary.m_logins;
+	unsigned int   dmrd   = primary.m_dmrd;
+
+	primary.sendNak();
+	run(*network, primary, NULL, 15000U);
+
+	CHECK(primary.m_logins > logins);
+	CHECK(primary.getPeerPort() == port);
+	CHECK(primary.m_dmrd > dmrd);
+
+	network->close();
+	delete network;
+}
+
+// A datagram the socket cannot send to the secondary, here a broadcast without SO_BROADCAST, only starts
+// the secondary again and leaves the primary's session and source port alone
+static void testWriteFailureKeepsOther()
+{
+	CFakeMaster primary;
+
+	CDMRNetwork* network = new CDMRNetwork("127.0.0.1", primary.getPort(), 1234567U, "passw0rd", true, "Test", false, true, true, "MMDVM");
+	network->setSecondary("255.255.255.255", 62031U, "passw0rd");
+	network->setConfig("N0CALL", 439000000U, 439000000U, 1U, 1U, 0.0F, 0.0F, 0, "Nowhere", "Test", "");
+
+	CHECK(network->open());
+	network->enable(true);
+
+	run(*network, primary, NULL, 15000U);
+
+	unsigned short port   = primary.getPeerPort();
+	unsigned int   logins = primary.m_logins;
+	unsigned int   dmrd   = primary.m_dmrd;
+	CHECK(logins > 0U);
+	CHECK(dmrd > 0U);
+
+	run(*network, primary, NULL, 30000U);
+
+	CHECK(primary.m_logins == logins);
+	CHECK(primary.getPeerPort() == port);
+	CHECK(primary.m_dmrd > dmrd);
+
+	network->close();
+	delete network;
+}
+
+// A master whose name takes seconds to resolve never holds up open() or clock(), and the login goes
+// ahead once the resolver thread has the answer
+static void testSlowResolver()
+{
+	CFakeMaster primary;
+
+	CDNSResolver::start(300U);
+
+	CDMRNetwork* network = new CDMRNetwork("slow.test", primary.getPort(), 1234567U, "passw0rd", true, "Test", false, true, true, "MMDVM");
+	network->setConfig("N0CALL", 439000000U, 439000000U, 1U, 1U, 0.0F, 0.0F, 0, "Nowhere", "Test", "");
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	CHECK(network->open());
+	network->enable(true);
+
+	unsigned int worst = elapsedMs(start);
+
+	// Fake time runs five times faster than real time to reach the login retries sooner
+	while (primary.m_logins == 0U && elapsedMs(start) < 5U * SLOW_LOOKUP_TIME) {
+		::usleep(10000);
+		g_fakeTime += 50U;
+
+		std::chrono::steady_clock::time_point call = std::chrono::steady_clock::now();
+		network->clock(50U);
+		network->flush();
+		worst = std::max(worst, elapsedMs(call));
+
+		primary.clock();
+	}
+
+	CHECK(primary.m_logins > 0U);
+	CHECK(elapsedMs(start) >= SLOW_LOOKUP_TIME);
+	CHECK(worst < MAX_CALL_TIME);
+
+	network->close();
+	delete network;
+
+	CDNSResolver::stop();
+}
+
+int main()
+{
+	::LogInitialise(".", "DMRNetworkTest", 0U, 2U, 0U, false);
+
+	testFailover();
+	testStandbyKeepsSocket();
+	testSingleMasterReopens();
+	testNakRelogsIn();
+	testBurst();
+	testSeqNo();
+	testRouting();
+	testDuplicateStream();
+	testWriteFailureKeepsOther();
+	testSlowResolver();
+
+	return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FakeStopWatch.h"
+#include "RSSIInterpolator.h"
+#include "NullDisplay.h"
+#include "DMRDefines.h"
+#include "DMRSlotType.h"
+#include "DMRFullLC.h"
+#include "DMRSlot.h"
+#include "Modem.h"
+#include "Sync.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+const unsigned int FRAME_TIME = 60U;
+const unsigned int STEP       = 5U;
+
+static unsigned int m_allocations = 0U;
+static bool         m_counting    = false;
+
+void* operator new(size_t size)
+{
+	if (m_counting)
+		m_allocations++;
+
+	void* p = ::malloc(size);
+	if (p == NULL)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	::free(p);
+}
+
+// The slot only tells the modem about the call, which has nowhere to go here
+class CFakeModem : public CModem {
+public:
+	CFakeModem() :
+	CModem("/dev/null", false, false, false, false, 100U, 0U, false, false)
+	{
+	}
+
+	virtual bool writeDMRShortLC(const unsigned char*)
+	{
+		return true;
+	}
+
+	virtual bool writeDMRAbort(unsigned int)
+	{
+		return true;
+	}
+};
+
+static CDMRData makeData(unsigned char seqNo, unsigned char dataType, unsigned char n, const unsigned char* frame)
+{
+	CDMRData data;
+	data.setSlotNo(2U);
+	data.setSrcId(1234567U);
+	data.setDstId(9U);
+	data.setFLCO(FLCO_GROUP);
+	data.setStreamId(0x1234U);
+	data.setSeqNo(seqNo);
+	data.setDataType(dataType);
+	data.setN(n);
+	data.setData(frame);
+
+	return data;
+}
+
+// Runs the slot the way the main loop does for one frame time, returning the frames sent to the modem
+static unsigned int run(CDMRSlot& slot)
+{
+	unsigned int count = 0U;
+
+	for (unsigned int elapsed = 0U; elapsed < FRAME_TIME; elapsed += STEP) {
+		g_fakeTime += STEP;
+
+		slot.clock();
+
+		unsigned char buffer[DMR_FRAME_LENGTH_BYTES + 2U];
+		unsigned long long timestamp;
+		while (slot.readModem(buffer, timestamp) > 0U)
+			count++;
+	}
+
+	return count;
+}
+
+// Once a call is up each network voice frame goes through the jitter buffer and the slot queue to the
+// modem without touching the heap
+static void testVoice(unsigned int jitter)
+{
+	CDMRSlot slot(2U, 180U, jitter);
+	slot.enable(true);
+
+	CDMRLC lc(FLCO_GROUP, 1234567U, 9U);
+
+	unsigned char header[DMR_FRAME_LENGTH_BYTES];
+	CDMRFullLC fullLC;
+	fullLC.encode(lc, header, DT_VOICE_LC_HEADER);
+
+	CDMRSlotType slotType;
+	slotType.setColorCode(1U);
+	slotType.setDataType(DT_VOICE_LC_HEADER);
+	slotType.getData(header);
+	CSync::addDMRDataSync(header, false);
+
+	unsigned char seqNo = 0U;
+	slot.writeNetwork(makeData(seqNo++, DT_VOICE_LC_HEADER, 0U, header));
+	run(slot);
+
+	unsigned int frames = 0U;
+
+	m_allocations = 0U;
+	m_counting    = true;
+
+	for (unsigned int i = 0U; i < 300U; i++) {
+		unsigned char n = i % 6U;
+		slot.writeNetwork(makeData(seqNo++, n == 0U ? DT_VOICE_SYNC : DT_VOICE, n, DMR_SILENCE_DATA + 2U));
+		frames += run(slot);
+	}
+
+	m_counting = false;
+
+	CHECK(frames >= 290U);
+	CHECK(m_allocations == 0U);
+}
+
+int main()
+{
+	::LogInitialise(".", "DMRSlotAllocTest", 0U, 2U, 0U, false);
+
+	CFakeModem modem;
+	CNullDisplay display;
+	CRSSIInterpolator rssi;
+	std::vector<CDMRNetwork*> networks;
+
+	CDMRSlot::init(1U, false, false, 3U, &modem, networks, &display, false, &rssi, DMR_OVCM_OFF);
+
+	testVoice(0U);
+	testVoice(360U);
+
+	return 0;
+}
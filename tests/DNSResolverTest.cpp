@@ -0,0 +1,183 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "DNSResolver.h"
+#include "FakeResolver.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <thread>
+#include <chrono>
+
+const unsigned short PORT = 62031U;
+
+static std::string toString(const sockaddr_storage& address)
+{
+	char buffer[INET_ADDRSTRLEN];
+	CHECK(::inet_ntop(AF_INET, &((const sockaddr_in*)&address)->sin_addr, buffer, sizeof(buffer)) != NULL);
+
+	return buffer;
+}
+
+// Polls the cache until the name resolves to the given address or the time runs out
+static bool waitFor(const std::string& hostName, const char* expected, unsigned int ms)
+{
+	for (unsigned int elapsed = 0U; elapsed < ms; elapsed += 10U) {
+		sockaddr_storage address;
+		unsigned int addressLength;
+		if (CDNSResolver::lookup(hostName, PORT, address, addressLength) && toString(address) == expected)
+			return true;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	return false;
+}
+
+// Without the thread every lookup goes straight to the resolver, and numeric addresses never do
+static void testBlocking()
+{
+	fakeSetAddress("blocking.test", "10.0.0.1");
+
+	sockaddr_storage address;
+	unsigned int addressLength;
+	CHECK(CDNSResolver::lookup("blocking.test", PORT, address, addressLength));
+	CHECK(toString(address) == "10.0.0.1");
+	CHECK(ntohs(((sockaddr_in*)&address)->sin_port) == PORT);
+	CHECK(addressLength == sizeof(sockaddr_in));
+
+	CHECK(CDNSResolver::lookup("blocking.test", PORT, address, addressLength));
+	CHECK(fakeLookups("blocking.test") == 2U);
+
+	CHECK(!CDNSResolver::lookup("unknown.test", PORT, address, addressLength));
+
+	CHECK(CDNSResolver::lookup("10.0.0.9", PORT, address, addressLength));
+	CHECK(toString(address) == "10.0.0.9");
+	CHECK(fakeLookups("10.0.0.9") == 0U);
+}
+
+// The first lookup only queues the name, once resolved it is answered from the cache
+static void testCache()
+{
+	fakeSetAddress("cache.test", "10.0.0.2");
+
+	sockaddr_storage address;
+	unsigned int addressLength;
+	CHECK(!CDNSResolver::lookup("cache.test", PORT, address, addressLength));
+	CHECK(waitFor("cache.test", "10.0.0.2", 1000U));
+
+	unsigned int lookups = fakeLookups("cache.test");
+	CHECK(lookups == 1U);
+
+	for (unsigned int i = 0U; i < 100U; i++)
+		CHECK(CDNSResolver::lookup("cache.test", PORT, address, addressLength));
+
+	CHECK(fakeLookups("cache.test") == lookups);
+}
+
+// Asking for a refresh resolves the name again straight away and picks up the new address
+static void testRefresh()
+{
+	fakeSetAddress("cache.test", "10.0.0.3");
+
+	unsigned int lookups = fakeLookups("cache.test");
+	CDNSResolver::refresh("cache.test", PORT);
+
+	CHECK(waitFor("cache.test", "10.0.0.3", 500U));
+	CHECK(fakeLookups("cache.test") == lookups + 1U);
+}
+
+// A failed refresh keeps the last good address
+static void testRefreshFailure()
+{
+	fakeSetAddress("cache.test", NULL);
+
+	unsigned int lookups = fakeLookups("cache.test");
+	CDNSResolver::refresh("cache.test", PORT);
+
+	for (unsigned int i = 0U; i < 50U && fakeLookups("cache.test") == lookups; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	CHECK(fakeLookups("cache.test") > lookups);
+	CHECK(waitFor("cache.test", "10.0.0.3", 100U));
+}
+
+// A name that fails to resolve is tried again later, and works once the resolver has an answer
+static void testRetry()
+{
+	sockaddr_storage address;
+	unsigned int addressLength;
+	CHECK(!CDNSResolver::lookup("retry.test", PORT, address, addressLength));
+
+	for (unsigned int i = 0U; i < 50U && fakeLookups("retry.test") == 0U; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+	CHECK(fakeLookups("retry.test") == 1U);
+	CHECK(!CDNSResolver::lookup("retry.test", PORT, address, addressLength));
+
+	fakeSetAddress("retry.test", "10.0.0.4");
+
+	CHECK(waitFor("retry.test", "10.0.0.4", 2500U));
+	CHECK(fakeLookups("retry.test") == 2U);
+}
+
+// A slow resolver holds up neither a new name nor the names already in the cache
+static void testSlow()
+{
+	fakeSetAddress("slow.test", "10.0.0.5");
+	g_fakeLookupDelay = 500U;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	sockaddr_storage address;
+	unsigned int addressLength;
+	CHECK(!CDNSResolver::lookup("slow.test", PORT, address, addressLength));
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	CHECK(fakeLookups("slow.test") == 1U);
+
+	CHECK(CDNSResolver::lookup("cache.test", PORT, address, addressLength));
+	CHECK(!CDNSResolver::lookup("slow.test", PORT, address, addressLength));
+
+	CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250));
+
+	CHECK(waitFor("slow.test", "10.0.0.5", 1000U));
+
+	g_fakeLookupDelay = 0U;
+}
+
+int main()
+{
+	::LogInitialise(".", "DNSResolverTest", 0U, 2U, 0U, false);
+
+	testBlocking();
+
+	// The shortest refresh, failed names are tried again after a second too
+	CHECK(CDNSResolver::start(1U));
+
+	testCache();
+	testRefresh();
+	testRefreshFailure();
+	testRetry();
+	testSlow();
+
+	CDNSResolver::stop();
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FakeResolver.h"
+#include "UDPSocket.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+unsigned int g_fakeLookupDelay = 0U;
+
+static std::map<std::string, std::string> m_addresses;
+static std::map<std::string, unsigned int> m_lookups;
+static std::mutex m_mutex;
+
+void fakeSetAddress(const std::string& hostName, const char* address)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (address == NULL)
+		m_addresses.erase(hostName);
+	else
+		m_addresses[hostName] = address;
+}
+
+unsigned int fakeLookups(const std::string& hostName)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_lookups[hostName];
+}
+
+int CUDPSocket::lookup(const std::string& hostName, unsigned short port, sockaddr_storage& address, unsigned int& addressLength)
+{
+	std::string numeric;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_lookups[hostName]++;
+
+		std::map<std::string, std::string>::const_iterator it = m_addresses.find(hostName);
+		if (it != m_addresses.end())
+			numeric = it->second;
+	}
+
+	if (g_fakeLookupDelay > 0U)
+		std::this_thread::sleep_for(std::chrono::milliseconds(g_fakeLookupDelay));
+
+	if (numeric.empty())
+		return EAI_NONAME;
+
+	::memset(&address, 0x00U, sizeof(sockaddr_storage));
+
+	sockaddr_in* in = (sockaddr_in*)&address;
+	if (::inet_pton(AF_INET, numeric.c_str(), &in->sin_addr) != 1)
+		return EAI_NONAME;
+
+	in->sin_family = AF_INET;
+	in->sin_port   = htons(port);
+	addressLength  = sizeof(sockaddr_in);
+
+	return 0;
+}
+
+bool CUDPSocket::match(const sockaddr_storage& addr1, const sockaddr_storage& addr2)
+{
+	const sockaddr_in* in_1 = (const sockaddr_in*)&addr1;
+	const sockaddr_in* in_2 = (const sockaddr_in*)&addr2;
+
+	return (addr1.ss_family == addr2.ss_family) && (in_1->sin_addr.s_addr == in_2->sin_addr.s_addr) && (in_1->sin_port == in_2->sin_port);
+}
@@ -0,0 +1,32 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#pragma once
+
+#include <string>
+
+// Tests linked with FakeResolver.cpp get a CUDPSocket::lookup() that answers from a table instead of the network.
+// A name set to a NULL address fails to resolve, a name never set fails too.
+extern void fakeSetAddress(const std::string& hostName, const char* address);
+
+// How many times the name has been looked up so far
+extern unsigned int fakeLookups(const std::string& hostName);
+
+// Every lookup takes this long, in ms, to stand in for a slow resolver
+extern unsigned int g_fakeLookupDelay;
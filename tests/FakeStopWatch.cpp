@@ -0,0 +1,49 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FakeStopWatch.h"
+#include "StopWatch.h"
+
+unsigned long long g_fakeTime = 1000000ULL;
+
+CStopWatch::CStopWatch() :
+m_startMS(0ULL)
+{
+}
+
+CStopWatch::~CStopWatch()
+{
+}
+
+unsigned long long CStopWatch::time() const
+{
+	return g_fakeTime;
+}
+
+unsigned long long CStopWatch::start()
+{
+	m_startMS = g_fakeTime;
+
+	return m_startMS;
+}
+
+unsigned int CStopWatch::elapsed()
+{
+	return (unsigned int)(g_fakeTime - m_startMS);
+}
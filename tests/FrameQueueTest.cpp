@@ -0,0 +1,249 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "FakeStopWatch.h"
+#include "FrameQueue.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <cstring>
+#include <thread>
+
+#include <unistd.h>
+
+const unsigned int STRESS_FRAMES = 1000000U;
+
+// Lengths up to 120 bytes in a 256 byte queue, so frames keep meeting the end of the buffer, sometimes
+// leaving room for the wrap marker and sometimes not
+static unsigned int frameLength(unsigned int n)
+{
+	return 1U + (n * 37U) % 120U;
+}
+
+static unsigned char frameByte(unsigned int n, unsigned int i)
+{
+	return (unsigned char)(n * 7U + i);
+}
+
+static void fill(unsigned char* data, unsigned int n)
+{
+	unsigned int length = frameLength(n);
+	for (unsigned int i = 0U; i < length; i++)
+		data[i] = frameByte(n, i);
+}
+
+static void check(const unsigned char* data, unsigned int length, unsigned int n)
+{
+	CHECK(length == frameLength(n));
+
+	for (unsigned int i = 0U; i < length; i++)
+		CHECK(data[i] == frameByte(n, i));
+}
+
+static void produce(CFrameQueue* queue)
+{
+	for (unsigned int n = 0U; n < STRESS_FRAMES; n++) {
+		unsigned int length = frameLength(n);
+
+		while (!queue->hasSpace(length))
+			std::this_thread::yield();
+
+		// Half of the frames are built in place and half are copied in
+		if ((n % 2U) == 0U) {
+			unsigned char* data = queue->reserve(length);
+			CHECK(data != NULL);
+			fill(data, n);
+			queue->commit(length);
+		} else {
+			unsigned char data[120U];
+			fill(data, n);
+			CHECK(queue->addData(data, length));
+		}
+	}
+}
+
+// One thread produces while another consumes, every frame comes out whole and in order
+static void testStress()
+{
+	CFrameQueue queue(256U, "Stress");
+
+	std::thread producer(produce, &queue);
+
+	for (unsigned int n = 0U; n < STRESS_FRAMES; n++) {
+		// Half of the frames are read in place and half are copied out
+		if ((n % 3U) == 0U) {
+			unsigned int length;
+			const unsigned char* data;
+			while ((data = queue.peek(length)) == NULL)
+				std::this_thread::yield();
+
+			check(data, length, n);
+			queue.pop();
+		} else {
+			unsigned char data[120U];
+			unsigned int length;
+			while ((length = queue.getData(data)) == 0U)
+				std::this_thread::yield();
+
+			check(data, length, n);
+		}
+	}
+
+	producer.join();
+
+	CHECK(queue.isEmpty());
+	CHECK(queue.getDropped() == 0U);
+}
+
+// Adds frames of the given lengths, each numbered in turn, and reads each back straight away
+static void pass(CFrameQueue& queue, unsigned int& n, const unsigned int* lengths, unsigned int count)
+{
+	for (unsigned int i = 0U; i < count; i++, n++) {
+		unsigned char data[30U];
+		for (unsigned int j = 0U; j < lengths[i]; j++)
+			data[j] = frameByte(n, j);
+
+		CHECK(queue.addData(data, lengths[i]));
+
+		unsigned int length;
+		const unsigned char* frame = queue.peek(length);
+		CHECK(frame != NULL);
+		CHECK(length == lengths[i]);
+		for (unsigned int j = 0U; j < length; j++)
+			CHECK(frame[j] == frameByte(n, j));
+
+		queue.pop();
+		CHECK(queue.isEmpty());
+	}
+}
+
+// A frame that doesn't fit before the end of the buffer starts again at the beginning, whether or not
+// there is room left at the end for the wrap marker
+static void testWrap()
+{
+	CFrameQueue queue(64U, "Wrap");
+
+	unsigned int n = 0U;
+
+	// Frames of 22 and 32 bytes leave 10 at the end, and the third frame needs 12 so a marker is left
+	const unsigned int marker[] = {20U, 30U, 10U};
+	pass(queue, n, marker, 3U);
+
+	// From 12, frames of 30 and 21 bytes leave 1 at the end, too short for a marker
+	const unsigned int tail[] = {28U, 19U, 5U};
+	pass(queue, n, tail, 3U);
+
+	CHECK(queue.getDropped() == 0U);
+}
+
+// Runs the function, returning the number of overflow lines it logged
+template <typename F>
+static unsigned int countOverflowLogs(F function)
+{
+	std::string text = captureLog(function);
+
+	unsigned int count = 0U;
+	for (std::string::size_type pos = text.find("buffer overflow"); pos != std::string::npos; pos = text.find("buffer overflow", pos + 1U))
+		count++;
+
+	return count;
+}
+
+// Fills a 64 byte queue with 10 frames of 6 bytes, then offers 5 more
+static bool overflow(CFrameQueue& queue, unsigned int first)
+{
+	unsigned char data[4U];
+
+	bool all = true;
+	for (unsigned int n = first; n < first + 15U; n++) {
+		::memcpy(data, &n, sizeof(n));
+		if (!queue.addData(data, sizeof(data)))
+			all = false;
+	}
+
+	return all;
+}
+
+static unsigned int next(CFrameQueue& queue)
+{
+	unsigned char data[4U];
+	CHECK(queue.getData(data) == sizeof(data));
+
+	unsigned int n;
+	::memcpy(&n, data, sizeof(n));
+
+	return n;
+}
+
+// Each policy drops what it says and counts it, and a burst of drops is logged once a second at most
+static void testOverflow()
+{
+	CFrameQueue reject(64U, "Reject", FQO_REJECT);
+	CFrameQueue oldest(64U, "Oldest", FQO_DROP_OLDEST);
+	CFrameQueue clear(64U, "Clear", FQO_CLEAR);
+
+	unsigned int logs = countOverflowLogs([&]() {
+		CHECK(!overflow(reject, 0U));
+		CHECK(overflow(oldest, 0U));
+		CHECK(overflow(clear, 0U));
+	});
+
+	CHECK(logs == 3U);
+
+	CHECK(reject.getDropped() == 5U);
+	CHECK(next(reject) == 0U);
+
+	CHECK(oldest.getDropped() == 5U);
+	CHECK(next(oldest) == 5U);
+
+	CHECK(clear.getDropped() == 10U);
+	CHECK(next(clear) == 10U);
+
+	// Once it wraps the four bytes skipped at the end of the buffer count as used
+	CHECK(reject.getHighWater() == 60U);
+	CHECK(oldest.getHighWater() == 64U);
+
+	// Still within the second, the next burst is only counted
+	reject.clear();
+	logs = countOverflowLogs([&]() {
+		CHECK(!overflow(reject, 20U));
+	});
+	CHECK(logs == 0U);
+	CHECK(reject.getDropped() == 10U);
+
+	g_fakeTime += 1000ULL;
+
+	reject.clear();
+	logs = countOverflowLogs([&]() {
+		CHECK(!overflow(reject, 40U));
+	});
+	CHECK(logs == 1U);
+	CHECK(reject.getDropped() == 15U);
+}
+
+int main()
+{
+	::LogInitialise(".", "FrameQueueTest", 0U, 2U, 0U, false);
+
+	testWrap();
+	testOverflow();
+	testStress();
+
+	return 0;
+}
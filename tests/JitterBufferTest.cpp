@@ -0,0 +1,241 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "DMRJitterBuffer.h"
+#include "FakeStopWatch.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <algorithm>
+#include <vector>
+
+const unsigned int FRAME_TIME = 60U;
+const unsigned int MAX_DEPTH  = 360U;
+const unsigned int STEP       = 5U;
+
+struct FRAME {
+	unsigned long long arrival;
+	unsigned char      seqNo;
+	bool               lost;
+	unsigned long long played;
+};
+
+// Feeds the frames in at their arrival times while polling the buffer the way the main loop does
+static void run(CDMRJitterBuffer& buffer, std::vector<FRAME>& frames)
+{
+	unsigned long long end = frames.back().arrival + 2000ULL;
+
+	unsigned int next = 0U;
+	for (; g_fakeTime < end; g_fakeTime += STEP) {
+		while (next < frames.size() && frames[next].arrival <= g_fakeTime) {
+			if (!frames[next].lost) {
+				CDMRData data;
+				data.setSlotNo(1U);
+				data.setStreamId(0x1234U);
+				data.setSeqNo(frames[next].seqNo);
+				data.setSrcId(next);
+				buffer.addData(data);
+			}
+
+			next++;
+		}
+
+		CDMRData data;
+		JB_STATUS status;
+		while ((status = buffer.getData(data)) != JBS_NO_DATA) {
+			if (status == JBS_DATA)
+				frames[data.getSrcId()].played = g_fakeTime;
+		}
+	}
+}
+
+static std::vector<FRAME> makeStream(unsigned int count)
+{
+	std::vector<FRAME> frames(count);
+
+	for (unsigned int i = 0U; i < count; i++) {
+		frames[i].arrival = g_fakeTime + i * FRAME_TIME;
+		frames[i].seqNo   = i;
+		frames[i].lost    = false;
+		frames[i].played  = 0ULL;
+	}
+
+	return frames;
+}
+
+static unsigned long long delay(const FRAME& frame)
+{
+	CHECK(frame.played != 0ULL);
+	CHECK(frame.played >= frame.arrival);
+
+	return frame.played - frame.arrival;
+}
+
+// After an outage the frames that follow play at the normal depth, not after concealing the whole gap
+static void testGap()
+{
+	CDMRJitterBuffer buffer("Gap", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(100U);
+	for (unsigned int i = 20U; i < 53U; i++)
+		frames[i].lost = true;
+
+	run(buffer, frames);
+
+	for (unsigned int i = 53U; i < frames.size(); i++)
+		CHECK(delay(frames[i]) <= FRAME_TIME);
+}
+
+// A two second delay step plays on from the first delayed frame without dropping any
+static void testDelayStep()
+{
+	CDMRJitterBuffer buffer("Delay", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(100U);
+	for (unsigned int i = 20U; i < frames.size(); i++)
+		frames[i].arrival += 2000ULL;
+
+	run(buffer, frames);
+
+	for (unsigned int i = 0U; i < frames.size(); i++)
+		CHECK(delay(frames[i]) <= FRAME_TIME);
+
+	CHECK(buffer.getLate() == 0U);
+}
+
+// Two seconds of frames arriving together drops the oldest so the rest play within the maximum depth
+static void testBurst()
+{
+	CDMRJitterBuffer buffer("Burst", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(100U);
+	for (unsigned int i = 20U; i < 53U; i++)
+		frames[i].arrival = frames[53U].arrival;
+
+	run(buffer, frames);
+
+	for (unsigned int i = 20U; i < frames.size(); i++) {
+		if (frames[i].played != 0ULL)
+			CHECK(delay(frames[i]) <= MAX_DEPTH);
+	}
+
+	for (unsigned int i = 53U; i < frames.size(); i++)
+		CHECK(frames[i].played != 0ULL);
+
+	CHECK(buffer.getLate() > 0U);
+}
+
+// A sequence number jump of more than half the range while playing restarts the stream instead of dropping it as late
+static void testJump()
+{
+	CDMRJitterBuffer buffer("Jump", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(100U);
+	for (unsigned int i = 40U; i < frames.size(); i++)
+		frames[i].seqNo = i + 150U;
+
+	run(buffer, frames);
+
+	for (unsigned int i = 0U; i < frames.size(); i++)
+		CHECK(delay(frames[i]) <= FRAME_TIME);
+
+	CHECK(buffer.getLate() == 0U);
+}
+
+// A frame a little behind the head is still late rather than a restart, and deepens the buffer by a frame
+static void testLate()
+{
+	CDMRJitterBuffer buffer("Late", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(60U);
+	frames[30U].arrival += 5U * FRAME_TIME;
+
+	std::vector<FRAME> ordered;
+	for (unsigned int i = 0U; i < frames.size(); i++) {
+		if (i != 30U)
+			ordered.push_back(frames[i]);
+		if (i == 35U)
+			ordered.push_back(frames[30U]);
+	}
+
+	run(buffer, ordered);
+
+	CHECK(buffer.getLate() == 1U);
+	CHECK(buffer.getConcealed() == 1U);
+
+	for (unsigned int i = 0U; i < ordered.size(); i++) {
+		if (ordered[i].seqNo != 30U)
+			CHECK(delay(ordered[i]) <= 2U * FRAME_TIME);
+	}
+}
+
+// A 7.3 second call with every seventh pair of packets swapped in transit plays in order. A fresh buffer
+// starts too shallow for the first swap, which is late and deepens it, and every later swap is reordered
+static void testReorder()
+{
+	CDMRJitterBuffer buffer("Reorder", MAX_DEPTH);
+
+	std::vector<FRAME> frames = makeStream(122U);
+
+	unsigned int swapped = 0U;
+	for (unsigned int i = 6U; (i + 1U) < frames.size(); i += 14U) {
+		std::swap(frames[i].seqNo, frames[i + 1U].seqNo);
+		swapped++;
+	}
+
+	run(buffer, frames);
+
+	CHECK(buffer.getLate() <= 1U);
+	CHECK(buffer.getReordered() + buffer.getLate() == swapped);
+	CHECK(buffer.getConcealed() == buffer.getLate());
+
+	unsigned int lost = 0U;
+	unsigned long long last = 0ULL;
+	for (unsigned int seqNo = 0U; seqNo < frames.size(); seqNo++) {
+		for (unsigned int i = 0U; i < frames.size(); i++) {
+			if (frames[i].seqNo != seqNo)
+				continue;
+
+			if (frames[i].played == 0ULL) {
+				lost++;
+				continue;
+			}
+
+			CHECK(delay(frames[i]) <= MAX_DEPTH);
+			CHECK(frames[i].played > last);
+			last = frames[i].played;
+		}
+	}
+
+	CHECK(lost == buffer.getLate());
+}
+
+int main()
+{
+	::LogInitialise(".", "JitterBufferTest", 0U, 2U, 0U, false);
+
+	testGap();
+	testDelayStep();
+	testBurst();
+	testJump();
+	testLate();
+	testReorder();
+
+	return 0;
+}
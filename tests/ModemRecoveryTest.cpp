@@ -0,0 +1,247 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "Modem.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+const unsigned int ACK_DELAY = 150U;
+
+// Waiting in clock() for even one reply, however briefly, takes longer than this
+const unsigned int MAX_CLOCK_TIME = 10U;
+
+// A pseudo terminal has no modem control lines, so the RTS the serial controller asserts is taken as read
+extern "C" int ioctl(int fd, unsigned long request, ...)
+{
+	va_list ap;
+	va_start(ap, request);
+	void* arg = va_arg(ap, void*);
+	va_end(ap);
+
+	if (request == TIOCMGET || request == TIOCMSET)
+		return 0;
+
+	typedef int (*IOCTL)(int, unsigned long, void*);
+	static IOCTL next = (IOCTL)::dlsym(RTLD_NEXT, "ioctl");
+
+	return next(fd, request, arg);
+}
+
+static unsigned long long now()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Just enough of an MMDVM on the far side of a pseudo terminal to open, answer status polls and acknowledge
+// the frequency and configuration, each after a delay
+class CFakeMMDVM {
+public:
+	CFakeMMDVM() :
+	m_silent(false),
+	m_running(true),
+	m_fd(-1),
+	m_thread()
+	{
+		m_fd = ::posix_openpt(O_RDWR | O_NOCTTY);
+		CHECK(m_fd >= 0);
+		CHECK(::grantpt(m_fd) == 0);
+		CHECK(::unlockpt(m_fd) == 0);
+
+		::fcntl(m_fd, F_SETFL, O_NONBLOCK);
+
+		m_thread = std::thread(&CFakeMMDVM::run, this);
+	}
+
+	~CFakeMMDVM()
+	{
+		m_running = false;
+		m_thread.join();
+
+		::close(m_fd);
+	}
+
+	std::string getPort() const
+	{
+		return ::ptsname(m_fd);
+	}
+
+	// While silent everything from the host is swallowed unanswered
+	std::atomic<bool> m_silent;
+
+private:
+	struct REPLY {
+		unsigned long long due;
+		std::vector<unsigned char> data;
+	};
+
+	std::atomic<bool> m_running;
+	int               m_fd;
+	std::thread       m_thread;
+
+	void run()
+	{
+		std::vector<unsigned char> buffer;
+		std::vector<REPLY> replies;
+
+		while (m_running) {
+			// Polling fails at once while the host has the port closed
+			pollfd pfd;
+			pfd.fd      = m_fd;
+			pfd.events  = POLLIN;
+			pfd.revents = 0;
+			if (::poll(&pfd, 1, 5) > 0 && (pfd.revents & POLLHUP) != 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+			unsigned char data[256U];
+			ssize_t n = ::read(m_fd, data, sizeof(data));
+			if (n > 0)
+				buffer.insert(buffer.end(), data, data + n);
+
+			while (!buffer.empty() && buffer[0U] != 0xE0U)
+				buffer.erase(buffer.begin());
+
+			while (buffer.size() >= 3U && buffer.size() >= buffer[1U]) {
+				unsigned char command = buffer[2U];
+				buffer.erase(buffer.begin(), buffer.begin() + buffer[1U]);
+
+				if (!m_silent)
+					answer(command, replies);
+			}
+
+			unsigned long long t = now();
+			for (std::vector<REPLY>::iterator it = replies.begin(); it != replies.end();) {
+				if (it->due <= t) {
+					CHECK(::write(m_fd, it->data.data(), it->data.size()) == ssize_t(it->data.size()));
+					it = replies.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+	}
+
+	void answer(unsigned char command, std::vector<REPLY>& replies)
+	{
+		REPLY reply;
+		reply.due = now();
+
+		switch (command) {
+			case 0x00U: {		// GET_VERSION
+				const unsigned char version[] = {0xE0U, 14U, 0x00U, 1U, 'M', 'M', 'D', 'V', 'M', ' ', 't', 'e', 's', 't'};
+				reply.data.assign(version, version + sizeof(version));
+				}
+				break;
+			case 0x01U: {		// GET_STATUS
+				const unsigned char status[] = {0xE0U, 10U, 0x01U, 0x02U, 0x00U, 0x00U, 0x00U, 10U, 10U, 0x00U};
+				reply.data.assign(status, status + sizeof(status));
+				}
+				break;
+			case 0x02U:		// SET_CONFIG
+			case 0x04U: {		// SET_FREQ
+				const unsigned char ack[] = {0xE0U, 4U, 0x70U, command};
+				reply.data.assign(ack, ack + sizeof(ack));
+				reply.due += ACK_DELAY;
+				}
+				break;
+			default:
+				return;
+		}
+
+		replies.push_back(reply);
+	}
+};
+
+// Clocks the modem the way the main loop does until its error state becomes the one given or the time runs
+// out, returning the longest single clock() call
+static unsigned long long run(CModem& modem, unsigned int ms, bool error)
+{
+	unsigned long long worst = 0ULL;
+	unsigned long long last  = now();
+	unsigned long long end   = last + ms;
+
+	while (now() < end && modem.hasError() != error) {
+		unsigned long long start = now();
+		modem.clock((unsigned int)(start - last));
+		last = start;
+
+		unsigned long long took = now() - start;
+		if (took > worst)
+			worst = took;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+
+	return worst;
+}
+
+// After the modem stops answering, recovery reopens it and applies the frequency and configuration
+// again without any clock() call waiting for the replies
+static void testRecovery()
+{
+	CFakeMMDVM mmdvm;
+
+	CModem* modem = CModem::createModem(mmdvm.getPort(), true, false, false, false, 100U, 0U, false, false);
+	modem->setSerialParams("uart", 0U);
+	modem->setDMRParams(1U);
+	modem->setModeParams(true, false);
+	modem->setIOParams(false, 0U);
+
+	CHECK(modem->open());
+	CHECK(!modem->hasError());
+
+	// The inactivity timer only runs once a status reply has been seen
+	run(*modem, 1000U, true);
+	CHECK(!modem->hasError());
+
+	mmdvm.m_silent = true;
+	run(*modem, 5000U, true);
+	CHECK(modem->hasError());
+
+	mmdvm.m_silent = false;
+	unsigned long long worst = run(*modem, 15000U, false);
+	CHECK(!modem->hasError());
+
+	CHECK(worst < MAX_CLOCK_TIME);
+
+	modem->close();
+	delete modem;
+}
+
+int main()
+{
+	::LogInitialise(".", "ModemRecoveryTest", 0U, 2U, 0U, false);
+
+	testRecovery();
+
+	return 0;
+}
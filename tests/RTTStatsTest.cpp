@@ -0,0 +1,104 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#include "RTTStats.h"
+#include "Log.h"
+#include "Test.h"
+
+#include <string>
+
+static bool logs(const CRTTStats& stats, const char* expected)
+{
+	std::string text = captureLog([&]() {
+		stats.logStats("Test");
+	});
+
+	return text.find(expected) != std::string::npos;
+}
+
+// The figures come from the samples as they are, and missed pongs are counted apart from them
+static void testFigures()
+{
+	CRTTStats stats;
+
+	CHECK(logs(stats, "Test, no round trip times, 0 pongs missed"));
+
+	stats.addMissed();
+	CHECK(logs(stats, "Test, no round trip times, 1 pongs missed"));
+
+	// Out of order so that the percentiles have to sort them
+	for (unsigned int i = 0U; i < 100U; i++)
+		stats.addSample(1U + (i * 37U) % 100U);
+
+	stats.addMissed();
+	stats.addMissed();
+
+	CHECK(logs(stats, "Test, round trip over 100 pings: min 1ms, avg 50ms, p95 96ms, p99 100ms, max 100ms, 3 pongs missed"));
+
+	// Only the last 256 samples are kept
+	for (unsigned int i = 0U; i < 256U; i++)
+		stats.addSample(500U);
+
+	CHECK(logs(stats, "Test, round trip over 256 pings: min 500ms, avg 500ms, p95 500ms, p99 500ms, max 500ms, 3 pongs missed"));
+
+	stats.reset();
+	CHECK(logs(stats, "Test, no round trip times, 0 pongs missed"));
+}
+
+// The timeout follows RFC 6298 and stays within 100ms to 10s
+static void testRTO()
+{
+	CRTTStats stats;
+
+	// Nothing known about the link yet
+	CHECK(stats.getRTO() == 10000U);
+
+	// The first sample sets SRTT to it and RTTVAR to half of it, so RTO = SRTT + 4 * RTTVAR
+	stats.addSample(200U);
+	CHECK(stats.getRTO() == 600U);
+
+	// A steady link brings it down towards the RTT
+	for (unsigned int i = 0U; i < 100U; i++)
+		stats.addSample(200U);
+	CHECK(stats.getRTO() >= 200U);
+	CHECK(stats.getRTO() < 250U);
+
+	// A jump in the RTT opens it up again straight away
+	stats.addSample(1000U);
+	CHECK(stats.getRTO() > 1000U);
+
+	stats.reset();
+	for (unsigned int i = 0U; i < 10U; i++)
+		stats.addSample(1U);
+	CHECK(stats.getRTO() == 100U);
+
+	stats.reset();
+	stats.addSample(60000U);
+	CHECK(stats.getRTO() == 10000U);
+}
+
+int main()
+{
+	::LogInitialise(".", "RTTStatsTest", 0U, 2U, 0U, false);
+
+	testFigures();
+	testRTO();
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ *   Copyright (C) 2026 by BrandMeister
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+// Each test is its own executable, the first failed check ends it with a non-zero exit status
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			::exit(1); \
+		} \
+	} while (0)
+
+// Runs the function with stdout going to a file, returning what was logged
+template <typename F>
+static std::string captureLog(F function)
+{
+	char name[] = "/tmp/TestLogXXXXXX";
+	int fd = ::mkstemp(name);
+	CHECK(fd >= 0);
+	::unlink(name);
+
+	::fflush(stdout);
+	int saved = ::dup(STDOUT_FILENO);
+	::dup2(fd, STDOUT_FILENO);
+
+	function();
+
+	::fflush(stdout);
+	::dup2(saved, STDOUT_FILENO);
+	::close(saved);
+
+	FILE* fp = ::fdopen(fd, "r");
+	CHECK(fp != NULL);
+	::rewind(fp);
+
+	std::string text;
+	char line[200U];
+	while (::fgets(line, sizeof(line), fp) != NULL)
+		text += line;
+
+	::fclose(fp);
+
+	return text;
+}